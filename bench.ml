@@ -0,0 +1,242 @@
+(* Benchmarks on standard BDD, ADD and MTBDD workloads.
+
+   Each workload runs on a fresh manager, with fixed parameters, and
+   prints a line in JSON format with the value it computes (which should
+   not change from a run to another), its CPU time, the peak number of
+   nodes, the hit rate of the CUDD cache and the numbers of CUDD and
+   OCaml garbage collections.
+
+   Usage: bench.opt [workload ...] (all workloads by default), or
+   "make bench" in the source directory.
+*)
+
+open Format
+open Cudd
+
+(*  ********************************************************************** *)
+(** {2 Measures} *)
+(*  ********************************************************************** *)
+
+let measure (man:'a Man.t) (name:string) (param:int) (f:unit -> float) : unit =
+  Gc.compact ();
+  let gc0 = Gc.quick_stat () in
+  let t0 = Sys.time () in
+  let value = f () in
+  let time = Sys.time () -. t0 in
+  let gc1 = Gc.quick_stat () in
+  let lookups = Man.get_cache_lookups man in
+  let hits = Man.get_cache_hits man in
+  printf "{\"bench\":\"%s\",\"param\":%d,\"value\":%.17g,\"time\":%.3f,\"peak_nodes\":%d,\"nodes\":%d,\"cache_lookups\":%.0f,\"cache_hit_rate\":%.4f,\"cudd_gc\":%d,\"cudd_gc_time\":%.3f,\"reorderings\":%d,\"ocaml_minor_gc\":%d,\"ocaml_major_gc\":%d}@."
+    name param value time
+    (Man.get_node_count_peak man) (Man.get_node_count man)
+    lookups (if lookups>0.0 then hits /. lookups else 0.0)
+    (Man.get_gc_nb man) ((float_of_int (Man.get_gc_time man)) /. 1000.0)
+    (Man.get_reordering_nb man)
+    (gc1.Gc.minor_collections - gc0.Gc.minor_collections)
+    (gc1.Gc.major_collections - gc0.Gc.major_collections)
+
+(*  ********************************************************************** *)
+(** {2 Circuits on vectors of BDDs} *)
+(*  ********************************************************************** *)
+
+(* Vectors are little-endian arrays of BDDs *)
+
+let full_adder a b c =
+  let ab = Bdd.xor a b in
+  (Bdd.xor ab c, Bdd.dor (Bdd.dand a b) (Bdd.dand c ab))
+
+(* Sum of a and b, truncated to the size of a *)
+let adder man a b =
+  let carry = ref (Bdd.dfalse man) in
+  Array.mapi
+    (fun i ai ->
+      let bi = if i<Array.length b then b.(i) else Bdd.dfalse man in
+      let (s,c) = full_adder ai bi !carry in
+      carry := c;
+      s)
+    a
+
+(* Product of a and b, on 2n bits *)
+let multiplier man a b =
+  let n = Array.length a in
+  let acc = ref (Array.make (2*n) (Bdd.dfalse man)) in
+  for i=0 to n-1 do
+    let partial =
+      Array.init (2*n)
+	(fun j -> if j>=i && j-i<n then Bdd.dand b.(i) a.(j-i) else Bdd.dfalse man)
+    in
+    acc := adder man !acc partial
+  done;
+  !acc
+
+let total_size tab = Array.fold_left (fun n bdd -> n + Bdd.size bdd) 0 tab
+
+(*  ********************************************************************** *)
+(** {2 Workloads} *)
+(*  ********************************************************************** *)
+
+(* Number of solutions of the n-queens problem *)
+let queens n =
+  let man = Man.make_d ~numVars:(n*n) () in
+  measure man "queens" n (fun () ->
+    let x i j = Bdd.ithvar man (i*n+j) in
+    let res = ref (Bdd.dtrue man) in
+    for i=0 to n-1 do
+      let row = ref (Bdd.dfalse man) in
+      for j=0 to n-1 do row := Bdd.dor !row (x i j) done;
+      res := Bdd.dand !res !row;
+      for j=0 to n-1 do
+	(* a queen in (i,j) attacks no other queen *)
+	let free = ref (Bdd.dtrue man) in
+	let clear k l =
+	  if l>=0 && l<n then free := Bdd.dand !free (Bdd.dnot (x k l))
+	in
+	for k=0 to n-1 do
+	  if k<>j then clear i k;
+	  if k<>i then begin
+	    clear k j;
+	    clear k (j+k-i);
+	    clear k (j-k+i);
+	  end
+	done;
+	res := Bdd.dand !res (Bdd.dor (Bdd.dnot (x i j)) !free)
+      done
+    done;
+    Bdd.nbminterms (n*n) !res
+  )
+
+(* Adder on n bits, with interleaved inputs; checks commutativity and
+   returns the size of the outputs *)
+let adder_circuit n =
+  let man = Man.make_d ~numVars:(2*n) () in
+  measure man "adder" n (fun () ->
+    let a = Array.init n (fun i -> Bdd.ithvar man (2*i)) in
+    let b = Array.init n (fun i -> Bdd.ithvar man (2*i+1)) in
+    let s1 = adder man a b in
+    let s2 = adder man b a in
+    assert (Array.length s1 = Array.length s2);
+    Array.iteri (fun i s -> assert (Bdd.is_equal s s2.(i))) s1;
+    float_of_int (total_size s1)
+  )
+
+(* Multiplier on n bits, with interleaved inputs; returns the size of
+   the outputs *)
+let multiplier_circuit n =
+  let man = Man.make_d ~numVars:(2*n) () in
+  measure man "multiplier" n (fun () ->
+    let a = Array.init n (fun i -> Bdd.ithvar man (2*i)) in
+    let b = Array.init n (fun i -> Bdd.ithvar man (2*i+1)) in
+    let p = multiplier man a b in
+    float_of_int (total_size p)
+  )
+
+(* Reachable states of a counter on n bits with an enable input, by a
+   fixpoint of images; returns their number, 2^n *)
+let reachability n =
+  let man = Man.make_d ~numVars:(2*n+1) () in
+  measure man "reachability" n (fun () ->
+    let x i = Bdd.ithvar man (2*i) in
+    let x' i = Bdd.ithvar man (2*i+1) in
+    let enable = Bdd.ithvar man (2*n) in
+    let trans = ref (Bdd.dtrue man) in
+    let carry = ref enable in
+    for i=0 to n-1 do
+      trans := Bdd.dand !trans (Bdd.nxor (x' i) (Bdd.xor (x i) !carry));
+      carry := Bdd.dand !carry (x i)
+    done;
+    let cube = ref enable in
+    for i=0 to n-1 do cube := Bdd.dand !cube (x i) done;
+    let permut = Array.init (2*n+1) (fun i -> if i=2*n then i else i lxor 1) in
+    let init = ref (Bdd.dtrue man) in
+    for i=0 to n-1 do init := Bdd.dand !init (Bdd.dnot (x i)) done;
+    let rec fix reach =
+      let image = Bdd.permute (Bdd.existand !cube !trans reach) permut in
+      let reach' = Bdd.dor reach image in
+      if Bdd.is_equal reach reach' then reach else fix reach'
+    in
+    Bdd.nbminterms n (fix !init)
+  )
+
+(* Iterated products of a vector by a 0/1 matrix of size 2^n, with
+   Add.matrix_multiply; returns the sum of the entries of the result *)
+let matrix_vector n =
+  let iterations = 16 in
+  let man = Man.make_d ~numVars:(2*n) () in
+  measure man "matrix_vector" n (fun () ->
+    let x i = Bdd.ithvar man (2*i) in
+    let z i = Bdd.ithvar man (2*i+1) in
+    (* A(x,z) = 1 iff z = x or z = x+1 mod 2^n *)
+    let succ = ref (Bdd.dtrue man) in
+    let carry = ref (Bdd.dtrue man) in
+    for i=0 to n-1 do
+      succ := Bdd.dand !succ (Bdd.nxor (z i) (Bdd.xor (x i) !carry));
+      carry := Bdd.dand !carry (x i)
+    done;
+    let same = ref (Bdd.dtrue man) in
+    for i=0 to n-1 do same := Bdd.dand !same (Bdd.nxor (z i) (x i)) done;
+    let a = Add.of_bdd (Bdd.dor !succ !same) in
+    let zvars = Array.init n (fun i -> 2*i+1) in
+    let permut = Array.init (2*n) (fun i -> i lxor 1) in
+    (* v(x) = x+1 *)
+    let v = ref (Add.cst man 1.0) in
+    for i=0 to n-1 do
+      v := Add.add !v (Add.ite (x i) (Add.cst man (float_of_int (1 lsl i))) (Add.cst man 0.0))
+    done;
+    for k=1 to iterations do
+      v := Add.matrix_multiply zvars a (Add.permute !v permut)
+    done;
+    let sum = Add.matrix_multiply (Array.init n (fun i -> 2*i)) !v (Add.cst man 1.0) in
+    Add.dval sum
+  )
+
+(* Combination with User.map_op2 of MTBDDs with integer leaves on n
+   variables; returns the number of leaves of the result *)
+let mtbdd_map n =
+  let man = Man.make_v ~numVars:n () in
+  measure man "mtbdd_map" n (fun () ->
+    let table = Mtbddc.make_table ~hash:Hashtbl.hash ~equal:(=) in
+    let cst x = Mtbddc.cst man table x in
+    let lift op =
+      User.map_op2 ~commutative:true
+	(fun a b -> Mtbddc.unique table (op (Mtbddc.get a) (Mtbddc.get b)))
+    in
+    let sum weight =
+      let res = ref (cst 0) in
+      for i=0 to n-1 do
+	res := lift (+) !res (Vdd.ite (Bdd.ithvar man i) (cst (weight i)) (cst 0))
+      done;
+      !res
+    in
+    let f = sum (fun i -> i+1) in
+    let g = sum (fun i -> (i*i) mod 7 + 1) in
+    let h = lift (fun a b -> (a*b) mod 1009) f g in
+    float_of_int (Vdd.nbleaves h)
+  )
+
+(*  ********************************************************************** *)
+(** {2 Main} *)
+(*  ********************************************************************** *)
+
+let workloads = [
+  ("queens", (fun () -> queens 8));
+  ("adder", (fun () -> adder_circuit 64));
+  ("multiplier", (fun () -> multiplier_circuit 10));
+  ("reachability", (fun () -> reachability 10));
+  ("matrix_vector", (fun () -> matrix_vector 8));
+  ("mtbdd_map", (fun () -> mtbdd_map 16));
+]
+
+let _ =
+  let names =
+    if Array.length Sys.argv > 1
+    then List.tl (Array.to_list Sys.argv)
+    else List.map fst workloads
+  in
+  List.iter
+    (fun name ->
+      if not (List.mem_assoc name workloads) then begin
+	eprintf "bench: unknown workload %s@." name;
+	exit 2
+      end)
+    names;
+  List.iter (fun name -> (List.assoc name workloads) ()) names
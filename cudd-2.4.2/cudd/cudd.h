@@ -223,7 +223,8 @@ typedef enum {
     CUDD_TOO_MANY_NODES,
     CUDD_MAX_MEM_EXCEEDED,
     CUDD_INVALID_ARG,
-    CUDD_INTERNAL_ERROR
+    CUDD_INTERNAL_ERROR,
+    CUDD_TIMEOUT_EXPIRED
 } Cudd_ErrorType;
 
 
@@ -321,6 +322,8 @@ typedef DdNode * (*DD_CTFP)(DdManager *, DdNode *, DdNode *);
 typedef DdNode * (*DD_CTFP1)(DdManager *, DdNode *);
 /* Type of memory-out function. */
 typedef void (*DD_OOMFP)(long);
+/* Type of termination callback. */
+typedef int (*DD_THFP)(DdManager *, void *);
 /* Type of comparison function for qsort. */
 typedef int (*DD_QSFP)(const void *, const void *);
 
@@ -744,6 +747,8 @@ extern int Cudd_DisableReorderingReporting (DdManager *dd);
 extern int Cudd_ReorderingReporting (DdManager *dd);
 extern Cudd_ErrorType Cudd_ReadErrorCode (DdManager *dd);
 extern void Cudd_ClearErrorCode (DdManager *dd);
+extern void Cudd_RegisterTerminationCallback (DdManager *dd, DD_THFP callback, void *arg);
+extern void Cudd_UnregisterTerminationCallback (DdManager *dd);
 extern FILE * Cudd_ReadStdout (DdManager *dd);
 extern void Cudd_SetStdout (DdManager *dd, FILE *fp);
 extern FILE * Cudd_ReadStderr (DdManager *dd);
@@ -3634,6 +3634,54 @@ Cudd_ClearErrorCode(
 } /* end of Cudd_ClearErrorCode */
 
 
+/**Function********************************************************************
+
+  Synopsis    [Installs a termination callback.]
+
+  Description [Installs a function called by node allocation and by
+  some recursive procedures (conjunction, if-then-else, and-abstract).
+  If it returns a non-zero value, the current operation fails and
+  returns NULL, with the error code CUDD_TIMEOUT_EXPIRED. Only one
+  callback may be installed at a time.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cudd_UnregisterTerminationCallback Cudd_ReadErrorCode]
+
+******************************************************************************/
+void
+Cudd_RegisterTerminationCallback(
+  DdManager *dd,
+  DD_THFP callback,
+  void *arg)
+{
+    dd->terminationCallback = callback;
+    dd->tcbArg = arg;
+
+} /* end of Cudd_RegisterTerminationCallback */
+
+
+/**Function********************************************************************
+
+  Synopsis    [Removes the termination callback.]
+
+  Description []
+
+  SideEffects [None]
+
+  SeeAlso     [Cudd_RegisterTerminationCallback]
+
+******************************************************************************/
+void
+Cudd_UnregisterTerminationCallback(
+  DdManager *dd)
+{
+    dd->terminationCallback = NULL;
+    dd->tcbArg = NULL;
+
+} /* end of Cudd_UnregisterTerminationCallback */
+
+
 /**Function********************************************************************
 
   Synopsis    [Reads the stdout of a manager.]
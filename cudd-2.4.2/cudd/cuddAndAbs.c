@@ -204,6 +204,7 @@ cuddBddAndAbstractRecur(
     unsigned int topf, topg, topcube, top, index;
 
     statLine(manager);
+    if (cuddGiveUp(manager)) return(NULL);
     one = DD_ONE(manager);
     zero = Cudd_Not(one);
 
@@ -639,6 +639,7 @@ cuddBddIteRecur(
     int		 comple;
 
     statLine(dd);
+    if (cuddGiveUp(dd)) return(NULL);
     /* Terminal cases. */
 
     /* One variable cases. */
@@ -889,6 +890,7 @@ cuddBddAndRecur(
     unsigned int topf, topg, index;
 
     statLine(manager);
+    if (cuddGiveUp(manager)) return(NULL);
     one = DD_ONE(manager);
 
     /* Terminal cases. */
@@ -1017,6 +1019,7 @@ cuddBddXorRecur(
     unsigned int topf, topg, index;
 
     statLine(manager);
+    if (cuddGiveUp(manager)) return(NULL);
     one = DD_ONE(manager);
     zero = Cudd_Not(one);
 
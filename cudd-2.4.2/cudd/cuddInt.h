@@ -439,6 +439,8 @@ struct DdManager {	/* specialized DD symbol table */
 #pragma pointer_size short
 #endif
     Cudd_ErrorType errorCode;	/* info on last error */
+    DD_THFP terminationCallback; /* asks long operations to give up */
+    void *tcbArg;		/* argument of terminationCallback */
     /* Statistical counters. */
     unsigned long memused;	/* total memory allocated for the manager */
     unsigned long maxmem;	/* target maximum memory */
@@ -1009,6 +1011,27 @@ dd->nextSample += 250000;}
 #endif
 
 
+/**Macro***********************************************************************
+
+  Synopsis    [Checks whether the current operation should give up.]
+
+  Description [Calls the termination callback of the manager, if any.
+  If it returns a non-zero value, sets the error code of the manager
+  to CUDD_TIMEOUT_EXPIRED and evaluates to 1, so that recursive
+  procedures can return NULL as in case of memory exhaustion;
+  evaluates to 0 otherwise.]
+
+  SideEffects [none]
+
+  SeeAlso     [Cudd_RegisterTerminationCallback]
+
+******************************************************************************/
+#define cuddGiveUp(dd) \
+((dd)->terminationCallback != NULL && \
+ (*(dd)->terminationCallback)((dd),(dd)->tcbArg) && \
+ ((dd)->errorCode = CUDD_TIMEOUT_EXPIRED, 1))
+
+
 /**AutomaticStart*************************************************************/
 
 /*---------------------------------------------------------------------------*/
@@ -606,6 +606,8 @@ cuddInitTable(
     unique->out = stdout;
     unique->err = stderr;
     unique->errorCode = CUDD_NO_ERROR;
+    unique->terminationCallback = NULL;
+    unique->tcbArg = NULL;
 
     /* Initialize statistical counters. */
     unique->maxmemhard = ~ 0UL;
@@ -1222,6 +1224,8 @@ cuddUniqueInter(
 	}
     }
 
+    /* Give up before the counters of keys are updated. */
+    if (cuddGiveUp(unique)) return(NULL);
     gcNumber = unique->garbageCollections;
     looking = cuddAllocNode(unique);
     if (looking == NULL) {
@@ -1400,6 +1404,8 @@ cuddUniqueInterZdd(
 	return(NULL);
     }
 
+    /* Give up before the counters of keys are updated. */
+    if (cuddGiveUp(unique)) return(NULL);
     unique->keysZ++;
     subtable->keys++;
 
@@ -1484,6 +1490,8 @@ cuddUniqueConst(
 #endif
     }
 
+    /* Give up before the counters of keys are updated. */
+    if (cuddGiveUp(unique)) return(NULL);
     unique->keys++;
     unique->constants.keys++;
 
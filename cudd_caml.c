@@ -7,13 +7,22 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
 #include "caml/fail.h"
 #include "caml/alloc.h"
 #include "caml/custom.h"
 #include "caml/memory.h"
 #include "caml/callback.h"
+#include "caml/signals.h"
 #include "caml/camlidlruntime.h"
 #include "cudd_caml.h"
+#include "dddmp.h"
+
+/* Primitives of Gc.minor and Gc.major_slice */
+extern value caml_gc_minor(value v);
+extern value caml_gc_major_slice(value v);
 
 /* %======================================================================== */
 /* \section{Global tuning (Garbage collection)} */
@@ -22,7 +31,6 @@
 static mlsize_t camlidl_cudd_heap = 1 << 20;
 static value camlidl_cudd_gc_fun = Val_unit;
 static value camlidl_cudd_reordering_fun = Val_unit;
-static value camlidl_cudd_hash_clear_all_fun = Val_unit;
 static char camlidl_cudd_msg[160];
 
 value camlidl_cudd_set_gc(value _v_heap, value _v_gc, value _v_reordering)
@@ -34,33 +42,233 @@ value camlidl_cudd_set_gc(value _v_heap, value _v_gc, value _v_reordering)
   firstcall = (camlidl_cudd_gc_fun==Val_unit);
   camlidl_cudd_gc_fun = _v_gc;
   camlidl_cudd_reordering_fun = _v_reordering;
-  camlidl_cudd_hash_clear_all_fun = *caml_named_value("camlidl_cudd_hash_clear_all");
   if (firstcall){
     caml_register_global_root(&camlidl_cudd_gc_fun);
     caml_register_global_root(&camlidl_cudd_reordering_fun);
-    caml_register_global_root(&camlidl_cudd_hash_clear_all_fun);
   }
   CAMLreturn(Val_unit);
 }
 
+static long camlidl_cudd_man_next_id = 0;
+
+/* Attaches the state of the binding to a new manager. The hooks of the
+   manager are the default ones given to set_gc, until set_hooks is
+   called. */
+void camlidl_cudd_man_init(struct CuddauxMan* man)
+{
+  man->man->hooks = (char*)man;
+  man->gc_fun = Val_unit;
+  man->reordering_fun = Val_unit;
+  man->old_compactions = -1;
+  man->pending = NULL;
+  man->npending = 0;
+  man->maxpending = 0;
+  man->gc_policy = GC_DEFAULT;
+  man->gc_staged = 0.0;
+  memset(man->gc_stage,0,sizeof(man->gc_stage));
+  man->hashes = NULL;
+  memset(&man->limits,0,sizeof(man->limits));
+  man->profiling = false;
+  memset(man->builtin,0,sizeof(man->builtin));
+  man->id = camlidl_cudd_man_next_id++;
+  man->event_fun = Val_unit;
+  man->requested = false;
+  memset(man->event,0,sizeof(man->event));
+  caml_register_generational_global_root(&man->gc_fun);
+  caml_register_generational_global_root(&man->reordering_fun);
+  caml_register_generational_global_root(&man->event_fun);
+}
+
+value camlidl_cudd_man_set_hooks(value _v_man, value _v_gc, value _v_reordering)
+{
+  CAMLparam3(_v_man,_v_gc,_v_reordering);
+  struct CuddauxMan* man;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  caml_modify_generational_global_root(&man->gc_fun,_v_gc);
+  caml_modify_generational_global_root(&man->reordering_fun,_v_reordering);
+  CAMLreturn(Val_unit);
+}
+
+value camlidl_cudd_man_set_gc_staged(value _v_man, value _v_othreshold)
+{
+  CAMLparam2(_v_man,_v_othreshold);
+  struct CuddauxMan* man;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  man->gc_staged =
+    Is_long(_v_othreshold) ? 0.0 : Double_val(Field(_v_othreshold,0));
+  CAMLreturn(Val_unit);
+}
+
+value camlidl_cudd_man_get_gc_stats(value _v_man)
+{
+  CAMLparam1(_v_man); CAMLlocal2(res,v);
+  struct CuddauxMan* man;
+  int i;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  res = caml_alloc_tuple(6);
+  for (i=0; i<2; i++){
+    Store_field(res,3*i,Val_long(man->gc_stage[i].count));
+    v = caml_copy_double((double)man->gc_stage[i].time / 1000.0);
+    Store_field(res,3*i+1,v);
+    v = caml_copy_double(man->gc_stage[i].freed);
+    Store_field(res,3*i+2,v);
+  }
+  CAMLreturn(res);
+}
+
+/* The manager is read without camlidl_cudd_man_ml2c, which would flush
+   the buffer of pending dereferences. */
+value camlidl_cudd_man_flush_derefs(value _v_man)
+{
+  cuddauxManFlushDerefs(man_of_vmanager(_v_man));
+  return Val_unit;
+}
+
+value camlidl_cudd_man_get_pending_derefs(value _v_man)
+{
+  return Val_long(man_of_vmanager(_v_man)->npending);
+}
+
+/* Events reported to the event hook of a manager. The pre hooks record
+   the state of the manager in man->event[kind], the post hooks pass the
+   record Man.event to the OCaml hook, whose exceptions are ignored. */
+extern int ddTotalNumberSwapping;
+
+enum { CAMLIDL_CUDD_REORDERING, CAMLIDL_CUDD_GARBAGE };
+
+value camlidl_cudd_man_set_event_hook(value _v_man, value _v_ofun)
+{
+  CAMLparam2(_v_man,_v_ofun);
+  struct CuddauxMan* man;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  caml_modify_generational_global_root(&man->event_fun,
+				       Is_long(_v_ofun) ? Val_unit : Field(_v_ofun,0));
+  CAMLreturn(Val_unit);
+}
+
+static void camlidl_cudd_event_start(DdManager* dd, int kind, int heuristic, long start_time)
+{
+  struct CuddauxEvent* event = &cuddauxManOfDd(dd)->event[kind];
+  event->heuristic = heuristic;
+  event->start_time = start_time;
+  event->nodes = (long)dd->keys + (long)dd->keysZ;
+  event->dead = (long)dd->dead + (long)dd->deadZ;
+}
+
+static void camlidl_cudd_event_report(DdManager* dd, int kind, long swaps)
+{
+  CAMLparam0(); CAMLlocal2(res,v);
+  struct CuddauxMan* man = cuddauxManOfDd(dd);
+  struct CuddauxEvent* event = &man->event[kind];
+  long dead = (long)dd->dead + (long)dd->deadZ;
+
+  res = caml_alloc_tuple(9);
+  Store_field(res,0,Val_long(man->id));
+  Store_field(res,1,Val_int(kind));
+  Store_field(res,2,Val_bool(man->requested));
+  Store_field(res,3,Val_int(event->heuristic));
+  Store_field(res,4,Val_long(event->nodes));
+  Store_field(res,5,Val_long((long)dd->keys + (long)dd->keysZ));
+  Store_field(res,6,Val_long(swaps));
+  v = caml_copy_double((double)(util_cpu_time() - event->start_time) / 1000.0);
+  Store_field(res,7,v);
+  Store_field(res,8,Val_long(event->dead > dead ? event->dead - dead : 0));
+  caml_callback_exn(man->event_fun,res);
+  CAMLreturn0;
+}
+
 int camlidl_cudd_garbage(DdManager* dd, const char* s, void* data)
 {
-  if (camlidl_cudd_gc_fun==Val_unit){
+  struct CuddauxMan* man = cuddauxManOfDd(dd);
+  value gc_fun = man->gc_fun!=Val_unit ? man->gc_fun : camlidl_cudd_gc_fun;
+  unsigned int dead;
+  long time;
+  long start_time = util_cpu_time();
+  bool escalate = true;
+
+  if (gc_fun==Val_unit){
       fprintf(stderr,"mlcuddidl: cudd_caml.o: internal error: the \"let _ = set_gc ...\" line in manager.ml has not been executed\n");
       abort();
   }
-  caml_callback(camlidl_cudd_gc_fun,Val_unit);
+  if (man->gc_staged>0.0){
+    /* Stage 1: a minor collection, which finalizes the young dead
+       diagrams, and a major slice bounded by the size of the custom
+       blocks which may hold the nodes of the manager (3 words per
+       node), which advances the current major cycle without the pause
+       of a complete one. */
+    time = util_cpu_time();
+    dead = dd->dead;
+    caml_gc_minor(Val_unit);
+    caml_gc_major_slice(Val_long(3 * (long)dd->keys));
+    cuddauxManFlushDerefs(man);
+    man->gc_stage[0].count++;
+    man->gc_stage[0].time += util_cpu_time() - time;
+    man->gc_stage[0].freed += (double)dd->dead - (double)dead;
+    escalate = (double)dd->dead < man->gc_staged * (double)dd->keys;
+  }
+  if (escalate){
+    /* Stage 2: the hook, Gc.full_major by default */
+    time = util_cpu_time();
+    dead = dd->dead;
+    caml_callback(gc_fun,Val_unit);
+    /* Release the nodes of the OCaml values finalized so far, so that
+       they can be collected by the coming CUDD garbage collection */
+    cuddauxManFlushDerefs(man);
+    man->gc_stage[1].count++;
+    man->gc_stage[1].time += util_cpu_time() - time;
+    man->gc_stage[1].freed += (double)dd->dead - (double)dead;
+  }
+  /* Entries of hash tables with a key about to be collected */
+  cuddauxManPruneHashes(man);
+  camlidl_cudd_event_start(dd,CAMLIDL_CUDD_GARBAGE,CUDD_REORDER_NONE,start_time);
+  return 1;
+}
+
+int camlidl_cudd_postgarbage(DdManager* dd, const char* s, void* data)
+{
+  if (cuddauxManOfDd(dd)->event_fun!=Val_unit)
+    camlidl_cudd_event_report(dd,CAMLIDL_CUDD_GARBAGE,0);
   return 1;
 }
 
 int camlidl_cudd_reordering(DdManager* dd, const char* s, void* data)
 {
-  if (camlidl_cudd_reordering_fun==Val_unit || camlidl_cudd_hash_clear_all_fun==Val_unit){
+  struct CuddauxMan* man = cuddauxManOfDd(dd);
+  value reordering_fun = man->reordering_fun!=Val_unit ? man->reordering_fun : camlidl_cudd_reordering_fun;
+  long start_time = util_cpu_time();
+
+  if (reordering_fun==Val_unit){
     fprintf(stderr,"mlcuddidl: cudd_caml.o: internal error: the \"let _ = set_gc ...\" line in manager.ml has not been executed\n");
     abort();
   }
-  caml_callback(camlidl_cudd_hash_clear_all_fun, Val_unit);
-  caml_callback(camlidl_cudd_reordering_fun,Val_unit);
+  caml_callback(reordering_fun,Val_unit);
+  /* The hash tables of the manager are kept: their entries with a
+     live key are made valid during the reordering by referencing their
+     keys, the other ones are removed. Keys still referenced by a
+     previous reordering which failed before its post hook are released
+     first. */
+  cuddauxManPinHashes(man,false);
+  cuddauxManFlushDerefs(man);
+  cuddauxManPruneHashes(man);
+  if (!cuddauxManPinHashes(man,true)){
+    cuddauxManPinHashes(man,false);
+    dd->errorCode = CUDD_MEMORY_OUT;
+    return 0;
+  }
+  camlidl_cudd_event_start(dd,CAMLIDL_CUDD_REORDERING,(int)(ptrint)data,start_time);
+  return 1;
+}
+
+int camlidl_cudd_postreordering(DdManager* dd, const char* s, void* data)
+{
+  struct CuddauxMan* man = cuddauxManOfDd(dd);
+  cuddauxManPinHashes(man,false);
+  if (man->event_fun!=Val_unit)
+    camlidl_cudd_event_report(dd,CAMLIDL_CUDD_REORDERING,ddTotalNumberSwapping);
   return 1;
 }
 
@@ -100,6 +308,266 @@ This is done automatically by module Cudd.Mtbddc.");
   CAMLreturn (res);
 }
 
+/* %======================================================================== */
+/* \section{Limits on operations} */
+/* %======================================================================== */
+
+static double camlidl_cudd_now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv,NULL);
+  return (double)tv.tv_sec + 1e-6 * (double)tv.tv_usec;
+}
+
+static void camlidl_cudd_limit_start(DdManager* dd, struct CuddauxLimit* limit)
+{
+  limit->nsteps = 0.0;
+  limit->start_nodes = dd->allocated;
+  limit->start_time = limit->time>0.0 ? camlidl_cudd_now() : 0.0;
+}
+
+/* The clock is read only if clock is true */
+static bool camlidl_cudd_limit_exceeded(DdManager* dd, struct CuddauxLimit* limit, bool clock)
+{
+  return
+    (limit->steps>0.0 && limit->nsteps > limit->steps) ||
+    (limit->nodes>0.0 && dd->allocated - limit->start_nodes > limit->nodes) ||
+    (clock && limit->time>0.0 &&
+     camlidl_cudd_now() - limit->start_time > limit->time);
+}
+
+/* Restarts the limits of set_limits, at the start of an operation;
+   those of with_limits keep running */
+void camlidl_cudd_limits_start(struct CuddauxMan* man)
+{
+  struct CuddauxLimits* limits = &man->limits;
+  camlidl_cudd_limit_start(man->man,&limits->op);
+  limits->expired = camlidl_cudd_limit_exceeded(man->man,&limits->scope,true);
+}
+
+/* Termination callback: the clock is read every 1024 steps only. Once
+   a limit has been exceeded, the callback keeps asking to give up until
+   the limits are restarted. */
+static int camlidl_cudd_giveup(DdManager* dd, void* arg)
+{
+  struct CuddauxLimits* limits = &((struct CuddauxMan*)arg)->limits;
+  bool clock;
+
+  if (!limits->expired){
+    limits->op.nsteps += 1.0;
+    limits->scope.nsteps += 1.0;
+    clock = ((unsigned long)limits->scope.nsteps & 1023)==0;
+    limits->expired =
+      camlidl_cudd_limit_exceeded(dd,&limits->op,clock) ||
+      camlidl_cudd_limit_exceeded(dd,&limits->scope,clock);
+  }
+  return limits->expired;
+}
+
+/* Installs the termination callback iff a limit is set */
+static void camlidl_cudd_limits_update(struct CuddauxMan* man)
+{
+  struct CuddauxLimits* limits = &man->limits;
+  limits->active =
+    limits->op.time>0.0 || limits->op.nodes>0.0 || limits->op.steps>0.0 ||
+    limits->scope.time>0.0 || limits->scope.nodes>0.0 || limits->scope.steps>0.0;
+  if (limits->active)
+    Cudd_RegisterTerminationCallback(man->man,camlidl_cudd_giveup,man);
+  else {
+    Cudd_UnregisterTerminationCallback(man->man);
+    limits->expired = false;
+  }
+}
+
+value camlidl_cudd_man_set_limits(value _v_man, value _v_time, value _v_nodes, value _v_steps)
+{
+  CAMLparam4(_v_man,_v_time,_v_nodes,_v_steps);
+  struct CuddauxMan* man;
+  struct CuddauxLimit* op;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  op = &man->limits.op;
+  op->time = Double_val(_v_time);
+  op->nodes = Double_val(_v_nodes);
+  op->steps = Double_val(_v_steps);
+  camlidl_cudd_limit_start(man->man,op);
+  camlidl_cudd_limits_update(man);
+  CAMLreturn(Val_unit);
+}
+
+/* Intersection of a limit with what remains of the enclosing one, at
+   least min so that an exhausted enclosing limit remains exceeded */
+static double camlidl_cudd_limit_meet(double limit, double outer, double used, double min)
+{
+  double rem;
+  if (outer<=0.0) return limit;
+  rem = outer - used;
+  if (rem<min) rem = min;
+  return (limit>0.0 && limit<rem) ? limit : rem;
+}
+
+/* Enters a call of with_limits: returns the limits of the enclosing
+   one as a float array, to be given back to pop_limits. */
+value camlidl_cudd_man_push_limits(value _v_man, value _v_time, value _v_nodes, value _v_steps)
+{
+  CAMLparam4(_v_man,_v_time,_v_nodes,_v_steps); CAMLlocal1(_v_saved);
+  struct CuddauxMan* man;
+  struct CuddauxLimit outer, *scope;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  scope = &man->limits.scope;
+  outer = *scope;
+  _v_saved = caml_alloc(6 * Double_wosize, Double_array_tag);
+  Store_double_field(_v_saved,0,outer.time);
+  Store_double_field(_v_saved,1,outer.nodes);
+  Store_double_field(_v_saved,2,outer.steps);
+  Store_double_field(_v_saved,3,outer.start_time);
+  Store_double_field(_v_saved,4,outer.start_nodes);
+  Store_double_field(_v_saved,5,outer.nsteps);
+  scope->time =
+    camlidl_cudd_limit_meet(Double_val(_v_time),outer.time,
+			    outer.time>0.0 ? camlidl_cudd_now() - outer.start_time : 0.0,
+			    1e-6);
+  scope->nodes =
+    camlidl_cudd_limit_meet(Double_val(_v_nodes),outer.nodes,
+			    man->man->allocated - outer.start_nodes, 0.5);
+  scope->steps =
+    camlidl_cudd_limit_meet(Double_val(_v_steps),outer.steps,outer.nsteps,0.5);
+  camlidl_cudd_limit_start(man->man,scope);
+  camlidl_cudd_limits_update(man);
+  CAMLreturn(_v_saved);
+}
+
+/* Leaves a call of with_limits: the limits of the enclosing one are
+   restored without being restarted, the steps performed inside the
+   call being added to its counter */
+value camlidl_cudd_man_pop_limits(value _v_man, value _v_saved)
+{
+  CAMLparam2(_v_man,_v_saved);
+  struct CuddauxMan* man;
+  struct CuddauxLimits* limits;
+  double nsteps;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  limits = &man->limits;
+  nsteps = limits->scope.nsteps;
+  limits->scope.time = Double_field(_v_saved,0);
+  limits->scope.nodes = Double_field(_v_saved,1);
+  limits->scope.steps = Double_field(_v_saved,2);
+  limits->scope.start_time = Double_field(_v_saved,3);
+  limits->scope.start_nodes = Double_field(_v_saved,4);
+  limits->scope.nsteps = Double_field(_v_saved,5) + nsteps;
+  camlidl_cudd_limits_update(man);
+  if (limits->active)
+    limits->expired =
+      camlidl_cudd_limit_exceeded(man->man,&limits->op,true) ||
+      camlidl_cudd_limit_exceeded(man->man,&limits->scope,true);
+  CAMLreturn(Val_unit);
+}
+
+/* Raises Man.Timeout if the last operation gave up because of the
+   limits of the manager */
+static void camlidl_cudd_check_timeout(DdManager* dd)
+{
+  if (Cudd_ReadErrorCode(dd)==CUDD_TIMEOUT_EXPIRED){
+    Cudd_ClearErrorCode(dd);
+    caml_raise_constant(*caml_named_value("camlidl_cudd_timeout"));
+  }
+}
+
+static const char* camlidl_cudd_string_of_error(Cudd_ErrorType err)
+{
+  switch(err){
+  case CUDD_NO_ERROR: return "CUDD_NO_ERROR";
+  case CUDD_MEMORY_OUT: return "CUDD_MEMORY_OUT";
+  case CUDD_TOO_MANY_NODES: return "CUDD_TOO_MANY_NODES";
+  case CUDD_MAX_MEM_EXCEEDED: return "CUDD_MAX_MEM_EXCEEDED";
+  case CUDD_INVALID_ARG: return "CUDD_INVALID_ARG";
+  case CUDD_INTERNAL_ERROR: return "CUDD_INTERNAL_ERROR";
+  default: return "CUDD_UNKNOWN";
+  }
+}
+
+/* Used by the functions which handle a failure of CUDD themselves:
+   raises Man.Timeout, or Failure with the name of the function, if the
+   error code of the manager is set, after clearing it. */
+static void camlidl_cudd_check_error(DdManager* dd, const char* name)
+{
+  Cudd_ErrorType err;
+
+  camlidl_cudd_check_timeout(dd);
+  err = Cudd_ReadErrorCode(dd);
+  if (err!=CUDD_NO_ERROR){
+    Cudd_ClearErrorCode(dd);
+    snprintf(camlidl_cudd_msg,sizeof(camlidl_cudd_msg),
+	     "%s: ErrorCode = %s",name,camlidl_cudd_string_of_error(err));
+    caml_failwith(camlidl_cudd_msg);
+  }
+}
+
+/* %======================================================================== */
+/* \section{Profiling of operations} */
+/* %======================================================================== */
+
+/* The counters are returned as the record Custom.profile */
+static value camlidl_cudd_profile_c2ml(struct CuddauxProfile* prof)
+{
+  value res;
+  int i;
+
+  res = caml_alloc_tuple(10);
+  Store_field(res,0,Val_long(prof->calls));
+  Store_field(res,1,Val_long(prof->steps));
+  for (i=0; i<3; i++){
+    Store_field(res,2+2*i,Val_long(prof->hits[i]));
+    Store_field(res,3+2*i,Val_long(prof->misses[i]));
+  }
+  Store_field(res,8,Val_long(prof->callbacks));
+  Store_field(res,9,Val_long(prof->nodes));
+  return res;
+}
+
+value camlidl_cudd_pid_profile(value _v_pid)
+{
+  pid pid;
+  camlidl_cudd_pid_ml2c(_v_pid,&pid);
+  return camlidl_cudd_profile_c2ml((struct CuddauxProfile*)pid);
+}
+value camlidl_cudd_pid_reset_profile(value _v_pid)
+{
+  pid pid;
+  camlidl_cudd_pid_ml2c(_v_pid,&pid);
+  memset(pid,0,sizeof(struct CuddauxProfile));
+  return Val_unit;
+}
+
+value camlidl_cudd_builtin_profiles(value _v_man)
+{
+  CAMLparam1(_v_man); CAMLlocal3(res,v,pair);
+  struct CuddauxMan* man;
+  int i;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  res = caml_alloc_tuple(CUDDAUX_BUILTIN_NB);
+  for (i=0; i<CUDDAUX_BUILTIN_NB; i++){
+    v = caml_copy_string(cuddauxBuiltinName[i]);
+    pair = caml_alloc_tuple(2);
+    Store_field(pair,0,v);
+    v = camlidl_cudd_profile_c2ml(&man->builtin[i]);
+    Store_field(pair,1,v);
+    Store_field(res,i,pair);
+  }
+  CAMLreturn(res);
+}
+value camlidl_cudd_reset_builtin_profiles(value _v_man)
+{
+  struct CuddauxMan* man;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  memset(man->builtin,0,sizeof(man->builtin));
+  return Val_unit;
+}
+
 /* %======================================================================== */
 /* \section{Custom datatypes} */
 /* %======================================================================== */
@@ -244,8 +712,7 @@ void camlidl_custom_node_finalize(value val)
   node__t* no = node_of_vnode(val);
   DdNode* node = no->node;
   assert (Cudd_Regular(node)->ref >= 1);
-  Cudd_RecursiveDeref(no->man->man,node);
-  cuddauxManFree(no->man);
+  cuddauxManDeferDeref(no->man,node);
 }
 int camlidl_custom_node_compare(value val1, value val2)
 {
@@ -284,8 +751,7 @@ void camlidl_custom_bdd_finalize(value val)
   node__t* no = node_of_vnode(val);
   DdNode* node = no->node;
   assert((Cudd_Regular(node))->ref >= 1);
-  Cudd_IterDerefBdd(no->man->man,node);
-  cuddauxManFree(no->man);
+  cuddauxManDeferDeref(no->man,node);
 }
 
 struct custom_operations camlidl_custom_bdd = {
@@ -346,6 +812,35 @@ value camlidl_cudd_pid_c2ml(pid* ppid)
 
 /* \subsubsection{Standard nodes (BDDs \& ADDs)} */
 
+/* Parameters mem and max given to caml_alloc_custom for a new diagram
+   of the manager man.
+
+   With the policies other than GC_DEFAULT, mem is the average number
+   of bytes of live CUDD nodes held by a diagram of the manager, and
+   max is the memory used by CUDD (GC_FOOTPRINT) or 4 times this
+   memory (GC_THROUGHPUT). The ratios mem/max of the diagrams allocated
+   since the end of the previous major cycle add up to the work of the
+   major slices, which are thus sped up so that the current cycle
+   completes by the time these diagrams hold as many bytes as are used
+   by CUDD (resp. 4 times); no full cycle is forced. */
+static inline void camlidl_cudd_pacing(struct CuddauxMan* man, mlsize_t* pmem, mlsize_t* pmax)
+{
+  DdManager* dd = man->man;
+  mlsize_t live,inuse,count;
+
+  if (man->gc_policy==GC_DEFAULT){
+    *pmem = 1;
+    *pmax = camlidl_cudd_heap;
+  }
+  else {
+    live = (mlsize_t)(dd->keys - dd->dead) * sizeof(DdNode);
+    inuse = (mlsize_t)Cudd_ReadMemoryInUse(dd);
+    count = man->count > man->npending ? man->count - man->npending : 1;
+    *pmem = live / count + 1;
+    *pmax = (man->gc_policy==GC_THROUGHPUT ? 4 : 1) * inuse + 1;
+  }
+}
+
 #ifndef NDEBUG
 int node_compteur = 0;
 int bdd_compteur=0;
@@ -358,20 +853,13 @@ int bdd_compteur=0;
 value camlidl_cudd_node_c2ml(struct node__t* no)
 {
   value val;
+  mlsize_t mem,max;
 
   if(no->node==0){
+    camlidl_cudd_check_timeout(no->man->man);
     Cudd_ErrorType err = Cudd_ReadErrorCode(no->man->man);
     Cudd_ClearErrorCode(no->man->man);
-    char *s;
-    switch(err){
-    case CUDD_NO_ERROR: s = "CUDD_NO_ERROR"; break;
-    case CUDD_MEMORY_OUT: s = "CUDD_MEMORY_OUT"; break;
-    case CUDD_TOO_MANY_NODES: s = "CUDD_TOO_MANY_NODES"; break;
-    case CUDD_MAX_MEM_EXCEEDED: s = "CUDD_MAX_MEM_EXCEEDED"; break;
-    case CUDD_INVALID_ARG: s = "CUDD_INVALID_ARG"; break;
-    case CUDD_INTERNAL_ERROR: s = "CUDD_INTERNAL_ERROR"; break;
-    default: s = "CUDD_UNKNOWN"; break;
-    }
+    const char *s = camlidl_cudd_string_of_error(err);
     sprintf(camlidl_cudd_msg,
 	    "Cudd: a function returned a null ADD/BDD node; ErrorCode = %s",
 	    s);
@@ -404,7 +892,8 @@ value camlidl_cudd_node_c2ml(struct node__t* no)
 #endif
   */
 
-  val = caml_alloc_custom(&camlidl_custom_node, sizeof(struct node__t), 1, camlidl_cudd_heap);
+  camlidl_cudd_pacing(no->man,&mem,&max);
+  val = caml_alloc_custom(&camlidl_custom_node, sizeof(struct node__t), mem, max);
   *(node__t*)(Data_custom_val(val)) = *no;
   return val;
 }
@@ -414,19 +903,12 @@ value camlidl_cudd_node_c2ml(struct node__t* no)
 value camlidl_cudd_bdd_c2ml(struct node__t* bdd)
 {
   value val;
+  mlsize_t mem,max;
 
   if(bdd->node==0){
+    camlidl_cudd_check_timeout(bdd->man->man);
     Cudd_ErrorType err = Cudd_ReadErrorCode(bdd->man->man);
-    char *s;
-    switch(err){
-    case CUDD_NO_ERROR: s = "CUDD_NO_ERROR"; break;
-    case CUDD_MEMORY_OUT: s = "CUDD_MEMORY_OUT"; break;
-    case CUDD_TOO_MANY_NODES: s = "CUDD_TOO_MANY_NODES"; break;
-    case CUDD_MAX_MEM_EXCEEDED: s = "CUDD_MAX_MEM_EXCEEDED"; break;
-    case CUDD_INVALID_ARG: s = "CUDD_INVALID_ARG"; break;
-    case CUDD_INTERNAL_ERROR: s = "CUDD_INTERNAL_ERROR"; break;
-    default: s = "CUDD_UNKNOWN"; break;
-    }
+    const char *s = camlidl_cudd_string_of_error(err);
     sprintf(camlidl_cudd_msg,
 	    "Cudd: a function returned a null BDD node; ErrorCode = %s",
 	    s);
@@ -441,7 +923,8 @@ value camlidl_cudd_bdd_c2ml(struct node__t* bdd)
   assert(Cudd_CheckKeys(bdd->man->man)==0);
   assert(Cudd_DebugCheck(bdd->man->man)==0);
   */
-  val = caml_alloc_custom(&camlidl_custom_bdd, sizeof(struct node__t), 1, camlidl_cudd_heap);
+  camlidl_cudd_pacing(bdd->man,&mem,&max);
+  val = caml_alloc_custom(&camlidl_custom_bdd, sizeof(struct node__t), mem, max);
   *(node__t*)(Data_custom_val(val)) = *bdd;
   return val;
 }
@@ -878,7 +1361,7 @@ value camlidl_cudd_abdd_vectorcompose_memo(bool bdd, value _v_memo, value _v_vec
 
   camlidl_cudd_node_ml2c(_v_no, &no);
 
-  common.pid = bdd ? &camlidl_cudd_bdd_vectorcompose_memo : &camlidl_cudd_add_vectorcompose_memo;
+  common.pid = &no.man->builtin[bdd ? CUDDAUX_BDD_VECTORCOMPOSE_MEMO : CUDDAUX_ADD_VECTORCOMPOSE_MEMO];
   common.arity = 1;
   camlidl_cudd_memo_ml2c(_v_memo, &common.memo);
   common.man = no.man;
@@ -908,6 +1391,86 @@ value camlidl_cudd_abdd_vectorcompose_memo(bool bdd, value _v_memo, value _v_vec
   CAMLreturn(_vres);
 }
 
+value camlidl_cudd_bdd_dand_array(value _v_simplify, value _v_vec)
+{ return camlidl_cudd_abdd_apply_array(CUDDAUX_BDD_AND,"Bdd.dand_array",_v_simplify,_v_vec); }
+value camlidl_cudd_bdd_dor_array(value _v_simplify, value _v_vec)
+{ return camlidl_cudd_abdd_apply_array(CUDDAUX_BDD_OR,"Bdd.dor_array",_v_simplify,_v_vec); }
+value camlidl_cudd_add_add_array(value _v_vec)
+{ return camlidl_cudd_abdd_apply_array(CUDDAUX_ADD_PLUS,"Add.add_array",Val_false,_v_vec); }
+value camlidl_cudd_add_mul_array(value _v_vec)
+{ return camlidl_cudd_abdd_apply_array(CUDDAUX_ADD_TIMES,"Add.mul_array",Val_false,_v_vec); }
+
+value camlidl_cudd_abdd_apply_array(enum cuddaux_nary op, const char* name,
+				    value _v_simplify, value _v_vec)
+{
+  CAMLparam2(_v_simplify,_v_vec); CAMLlocal2(_v,_vres);
+  DdNode **vec; /*in*/
+  int size; /*in*/
+  bdd__t _res;
+  man__t man;
+  int peak;
+  char msg[128];
+
+  size = Wosize_val(_v_vec);
+  if (size==0){
+    snprintf(msg,sizeof(msg),"%s called with an empty array",name);
+    caml_invalid_argument(msg);
+  }
+  vec = (DdNode**)malloc(size * sizeof(DdNode*));
+  if (vec==NULL){
+    snprintf(msg,sizeof(msg),"%s: out of memory",name);
+    caml_failwith(msg);
+  }
+  man = camlidl_cudd_tnode_ml2c(_v_vec,size,vec);
+  if (man==NULL){
+    free(vec);
+    snprintf(msg,sizeof(msg),"%s called with nodes belonging to different managers !",name);
+    caml_invalid_argument(msg);
+  }
+  _res.man = man;
+  _res.node = Cuddaux_ApplyArray(man->man, op, Bool_val(_v_simplify), vec, size, &peak);
+  free(vec);
+  if (op==CUDDAUX_BDD_AND || op==CUDDAUX_BDD_OR)
+    _v = camlidl_cudd_bdd_c2ml(&_res);
+  else
+    _v = camlidl_cudd_node_c2ml(&_res);
+  _vres = caml_alloc_tuple(2);
+  Store_field(_vres,0,_v);
+  Store_field(_vres,1,Val_int(peak));
+  CAMLreturn(_vres);
+}
+
+value camlidl_cudd_bdd_relprod_rename_vector(value _v_tsupp, value _v_trel, value _v_no)
+{
+  CAMLparam3(_v_tsupp,_v_trel,_v_no); CAMLlocal1(_vres);
+  DdNode **vec; /*in*/
+  int size; /*in*/
+  bdd__t no; /*in*/
+  bdd__t _res;
+  man__t man1,man2;
+
+  camlidl_cudd_node_ml2c(_v_no, &no);
+  size = Wosize_val(_v_trel);
+  if (size != (int)Wosize_val(_v_tsupp))
+    caml_invalid_argument("Bdd.relprod_rename_vector called with arrays of different lengths");
+  if (no.man->man->map == NULL)
+    caml_failwith("Bdd.relprod_rename_vector: empty table, Man.set_varmap has not been called !");
+  vec = (DdNode**)malloc((2*size+1) * sizeof(DdNode*));
+  if (size>0){
+    man1 = camlidl_cudd_tnode_ml2c(_v_tsupp,size,vec);
+    man2 = camlidl_cudd_tnode_ml2c(_v_trel,size,vec+size);
+    if (man1!=no.man || man2!=no.man){
+      free(vec);
+      caml_invalid_argument("Bdd.relprod_rename_vector called with BDDs belonging to different managers !");
+    }
+  }
+  _res.man = no.man;
+  _res.node = Cuddaux_bddAndAbstractVarMapVector(no.man->man, no.node, vec+size, vec, size);
+  free(vec);
+  _vres = camlidl_cudd_bdd_c2ml(&_res);
+  CAMLreturn(_vres);
+}
+
 /* %======================================================================== */
 /* \section{Variable Mapping} */
 /* %======================================================================== */
@@ -964,7 +1527,7 @@ value camlidl_cudd_abdd_permute_memo(bool bdd, value _v_memo, value _v_no, value
 
   camlidl_cudd_node_ml2c(_v_no, &no);
 
-  common.pid = bdd ? &camlidl_cudd_bdd_permute_memo : &camlidl_cudd_add_permute_memo;
+  common.pid = &no.man->builtin[bdd ? CUDDAUX_BDD_PERMUTE_MEMO : CUDDAUX_ADD_PERMUTE_MEMO];
   common.arity = 1;
   camlidl_cudd_memo_ml2c(_v_memo, &common.memo);
   common.man = no.man;
@@ -991,6 +1554,216 @@ value camlidl_cudd_abdd_permute_memo(bool bdd, value _v_memo, value _v_no, value
   CAMLreturn(_vres);
 }
 
+/* Common part of vectorcompose_array and permute_array: _v_memo is a
+   Memo.t option; without memoization table, the roots share a
+   temporary hash table. _v_arg is the array of BDDs substituted to
+   the variables, or the permutation if permute is true.
+
+   The wrappers of the results are allocated first, around the
+   constant one, before any buffer is malloced; the results then
+   replace the constant in place, so that no exception can be raised
+   while they are only referenced by tres. */
+static value camlidl_cudd_abdd_compose_array(bool bdd, bool permute, const char* name,
+					     value _v_memo, value _v_tno, value _v_arg)
+{
+  CAMLparam3(_v_memo,_v_tno,_v_arg); CAMLlocal2(_v,_vres);
+  DdNode **tno, **tres, **vec;
+  int* permut;
+  struct common common;
+  struct CuddauxHash hash;
+  bdd__t _res;
+  node__t* w;
+  man__t man;
+  int i, nb, size, maxsize, ok;
+  char msg[128];
+
+  nb = Wosize_val(_v_tno);
+  if (nb==0)
+    CAMLreturn(caml_alloc(0,0));
+  camlidl_cudd_node_ml2c(Field(_v_tno,0), &_res);
+  man = _res.man;
+  _res.node = DD_ONE(man->man);
+  _vres = caml_alloc(nb,0);
+  for (i=0; i<nb; i++){
+    _v = bdd ? camlidl_cudd_bdd_c2ml(&_res) : camlidl_cudd_node_c2ml(&_res);
+    Store_field(_vres,i,_v);
+  }
+  size = Wosize_val(_v_arg);
+  maxsize = (size>man->man->size) ? size : man->man->size;
+  tno = (DdNode**)malloc(nb * sizeof(DdNode*));
+  tres = (DdNode**)malloc(nb * sizeof(DdNode*));
+  vec = permute ? NULL : (DdNode**)malloc(maxsize * sizeof(DdNode*));
+  permut = permute ? (int*)malloc(maxsize * sizeof(int)) : NULL;
+  if (tno==NULL || tres==NULL || (permute ? permut==NULL : vec==NULL)){
+    free(permut); free(vec); free(tres); free(tno);
+    snprintf(msg,sizeof(msg),"%s: out of memory",name);
+    caml_failwith(msg);
+  }
+  if (camlidl_cudd_tnode_ml2c(_v_tno,nb,tno)!=man){
+    free(permut); free(vec); free(tres); free(tno);
+    snprintf(msg,sizeof(msg),"%s called with diagrams belonging to different managers !",name);
+    caml_invalid_argument(msg);
+  }
+  if (permute){
+    for (i=0; i<size; i++){
+      permut[i] = Int_val(Field(_v_arg,i));
+    }
+    for (i=size; i<maxsize; i++){
+      permut[i] = i;
+    }
+  }
+  else {
+    if (size>0 && camlidl_cudd_tnode_ml2c(_v_arg,size,vec)!=man){
+      free(vec); free(tres); free(tno);
+      snprintf(msg,sizeof(msg),"%s called with BDDs belonging to different managers !",name);
+      caml_invalid_argument(msg);
+    }
+    for (i=size; i<maxsize; i++){
+      vec[i] = man->man->vars[i];
+    }
+  }
+  common.pid = &man->builtin[permute ?
+			     (bdd ? CUDDAUX_BDD_PERMUTE_MEMO : CUDDAUX_ADD_PERMUTE_MEMO) :
+			     (bdd ? CUDDAUX_BDD_VECTORCOMPOSE_MEMO : CUDDAUX_ADD_VECTORCOMPOSE_MEMO)];
+  common.arity = 1;
+  common.man = man;
+  if (Is_block(_v_memo)){
+    camlidl_cudd_memo_ml2c(Field(_v_memo,0), &common.memo);
+  } else {
+    common.memo.discr = Hash;
+    common.memo.u.hash = &hash;
+    hash.hash = NULL;
+    hash.arity = 1;
+    hash.initialsize = 0;
+    hash.man = NULL;
+    hash.pins = NULL;
+    hash.npins = 0;
+  }
+  ok = permute ?
+    Cuddaux_PermuteArrayCommon(&common,bdd,tno,nb,permut,tres) :
+    Cuddaux_VectorComposeArrayCommon(&common,bdd,tno,nb,vec,tres);
+  if (Is_long(_v_memo)) cuddauxCommonClear(&common);
+  free(permut); free(vec); free(tno);
+  if (!ok){
+    free(tres);
+    _res.node = NULL;
+    /* raises an exception */
+    if (bdd) camlidl_cudd_bdd_c2ml(&_res); else camlidl_cudd_node_c2ml(&_res);
+  }
+  /* The wrappers take over the references held by tres */
+  for (i=0; i<nb; i++){
+    w = (node__t*)Data_custom_val(Field(_vres,i));
+    Cudd_RecursiveDeref(man->man,w->node);
+    w->node = tres[i];
+  }
+  free(tres);
+  CAMLreturn(_vres);
+}
+
+value camlidl_cudd_bdd_vectorcompose_array(value _v_memo, value _v_vec, value _v_tno)
+{ return camlidl_cudd_abdd_compose_array(true,false,"Bdd.vectorcompose_array",_v_memo,_v_tno,_v_vec); }
+value camlidl_cudd_add_vectorcompose_array(value _v_memo, value _v_vec, value _v_tno)
+{ return camlidl_cudd_abdd_compose_array(false,false,"Add.vectorcompose_array",_v_memo,_v_tno,_v_vec); }
+
+value camlidl_cudd_bdd_permute_array(value _v_memo, value _v_tno, value _v_permut)
+{ return camlidl_cudd_abdd_compose_array(true,true,"Bdd.permute_array",_v_memo,_v_tno,_v_permut); }
+value camlidl_cudd_add_permute_array(value _v_memo, value _v_tno, value _v_permut)
+{ return camlidl_cudd_abdd_compose_array(false,true,"Add.permute_array",_v_memo,_v_tno,_v_permut); }
+
+/* Common part of vectorcompose_sparse and permute_sparse: _v_subst is
+   an array of pairs (var,bdd), or of pairs (var,var) if permute is
+   true. */
+static value camlidl_cudd_abdd_sparse_compose(bool bdd, bool permute, const char* name,
+					      value _v_subst, value _v_no)
+{
+  CAMLparam2(_v_subst,_v_no); CAMLlocal2(_v,_vres);
+  struct CuddauxSubst* subst;
+  struct common common;
+  struct CuddauxHash hash;
+  bdd__t no, _res;
+  DdManager* dd;
+  DdNode* res;
+  int i, var, size, ok;
+  char msg[128];
+
+  camlidl_cudd_node_ml2c(_v_no, &no);
+  dd = no.man->man;
+  size = Wosize_val(_v_subst);
+  subst = (struct CuddauxSubst*)malloc((size>0 ? size : 1) * sizeof(struct CuddauxSubst));
+  if (subst==NULL){
+    snprintf(msg,sizeof(msg),"%s: out of memory",name);
+    caml_failwith(msg);
+  }
+  for (i=0; i<size; i++){
+    _v = Field(_v_subst,i);
+    var = Int_val(Field(_v,0));
+    if (var<0 || var>=dd->size){
+      free(subst);
+      snprintf(msg,sizeof(msg),"%s: variable %d not in the manager",name,var);
+      caml_invalid_argument(msg);
+    }
+    subst[i].index = var;
+    if (permute){
+      var = Int_val(Field(_v,1));
+      if (var<0 || var>=dd->size){
+	free(subst);
+	snprintf(msg,sizeof(msg),"%s: variable %d not in the manager",name,var);
+	caml_invalid_argument(msg);
+      }
+      subst[i].func = dd->vars[var];
+    } else {
+      bdd__t func;
+      camlidl_cudd_node_ml2c(Field(_v,1), &func);
+      if (func.man != no.man){
+	free(subst);
+	snprintf(msg,sizeof(msg),"%s called with BDDs belonging to different managers !",name);
+	caml_invalid_argument(msg);
+      }
+      subst[i].func = func.node;
+    }
+  }
+  common.pid = &no.man->builtin[permute ?
+				(bdd ? CUDDAUX_BDD_PERMUTE_MEMO : CUDDAUX_ADD_PERMUTE_MEMO) :
+				(bdd ? CUDDAUX_BDD_VECTORCOMPOSE_MEMO : CUDDAUX_ADD_VECTORCOMPOSE_MEMO)];
+  common.arity = 1;
+  common.man = no.man;
+  common.memo.discr = Hash;
+  common.memo.u.hash = &hash;
+  hash.hash = NULL;
+  hash.arity = 1;
+  hash.initialsize = 0;
+  hash.man = NULL;
+  hash.pins = NULL;
+  hash.npins = 0;
+  ok = Cuddaux_SparseComposeArrayCommon(&common,bdd,&no.node,1,subst,size,&res);
+  cuddauxCommonClear(&common);
+  if (!ok && Cudd_ReadErrorCode(dd)==CUDD_INVALID_ARG){
+    /* subst has been sorted by level, which detects duplicates without
+       any array indexed by the variables of the manager */
+    for (i=1; i<size && subst[i].index!=subst[i-1].index; i++);
+    var = i<size ? subst[i].index : -1;
+    free(subst);
+    Cudd_ClearErrorCode(dd);
+    snprintf(msg,sizeof(msg),"%s: variable %d substituted twice",name,var);
+    caml_invalid_argument(msg);
+  }
+  free(subst);
+  _res.man = no.man;
+  _res.node = ok ? res : NULL;
+  _vres = bdd ? camlidl_cudd_bdd_c2ml(&_res) : camlidl_cudd_node_c2ml(&_res);
+  Cudd_RecursiveDeref(dd,res);
+  CAMLreturn(_vres);
+}
+
+value camlidl_cudd_bdd_vectorcompose_sparse(value _v_subst, value _v_no)
+{ return camlidl_cudd_abdd_sparse_compose(true,false,"Bdd.vectorcompose_sparse",_v_subst,_v_no); }
+value camlidl_cudd_add_vectorcompose_sparse(value _v_subst, value _v_no)
+{ return camlidl_cudd_abdd_sparse_compose(false,false,"Add.vectorcompose_sparse",_v_subst,_v_no); }
+value camlidl_cudd_bdd_permute_sparse(value _v_no, value _v_permut)
+{ return camlidl_cudd_abdd_sparse_compose(true,true,"Bdd.permute_sparse",_v_permut,_v_no); }
+value camlidl_cudd_add_permute_sparse(value _v_no, value _v_permut)
+{ return camlidl_cudd_abdd_sparse_compose(false,true,"Add.permute_sparse",_v_permut,_v_no); }
+
 /* %======================================================================== */
 /* \section{Iterators} */
 /* %======================================================================== */
@@ -1140,35 +1913,380 @@ value camlidl_cudd_bdd_iter_prime(value _v_closure, value _v_lower, value _v_upp
   CAMLreturn(Val_unit);
 }
 
-/* %======================================================================== */
-/* \section{Cubes} */
-/* %======================================================================== */
+/* Variants of the previous iterators which fill a buffer provided by the
+   caller instead of allocating an array for each cube:
 
-value camlidl_cudd_cube_of_bdd(value _v_no)
+   - either a string, in which the character i is '0', '1' or '-' depending
+     on the value of the variable of index i in the cube;
+
+   - or an int array, the first n elements of which are the variables of the
+     cube (sparse representation), packed as (index lsl 1) lor phase.
+*/
+
+static void camlidl_cudd_check_buf(bool sparse, value _v_buf, int size, const char* msg)
 {
-  CAMLparam1(_v_no); CAMLlocal1(_v_res);
-  node__t no;
-  bdd__t _res;
-  camlidl_cudd_node_ml2c(_v_no,&no);
-  _res.man = no.man;
-  _res.node = Cudd_FindEssential(no.man->man,no.node);
-  _v_res = camlidl_cudd_bdd_c2ml(&_res);
-  CAMLreturn(_v_res);
+  if ((sparse ? Wosize_val(_v_buf) : caml_string_length(_v_buf)) < (mlsize_t)size){
+    caml_invalid_argument(msg);
+  }
 }
 
-value camlidl_cudd_cube_of_minterm(value _v_man, value _v_array)
+static int camlidl_cudd_fill_buf(bool sparse, value _v_buf, int* array, int size)
 {
-  CAMLparam2(_v_man,_v_array); CAMLlocal1(_v_res);
-  struct CuddauxMan* man;
-  int i,size,maxsize;
-  int* array;
-  bdd__t _res;
-
-  camlidl_cudd_man_ml2c(_v_man, &man);
-  size = Wosize_val(_v_array);
-  maxsize = Cudd_ReadSize(man->man);
-  if (size>maxsize){
-    caml_invalid_argument("Bdd.cube_of_minterm: array of size greater than the number of variables in manager");
+  int i,n;
+
+  n = 0;
+  if (sparse){
+    for (i=0; i<size; i++){
+      if (array[i]!=2){
+	Field(_v_buf,n) = Val_int((i<<1) | array[i]);
+	/* Allowed since Val_int(..) is not a pointer */
+	n++;
+      }
+    }
+  }
+  else {
+    for (i=0; i<size; i++){
+      Byte_u(_v_buf,i) = array[i]==2 ? '-' : '0'+array[i];
+    }
+    n = size;
+  }
+  return n;
+}
+
+value camlidl_cudd_bdd_iter_cube_str(value _v_closure, value _v_buf, value _v_no)
+{ return camlidl_cudd_abdd_iter_cube_buf(true,false,_v_closure,_v_buf,_v_no); }
+value camlidl_cudd_bdd_iter_cube_sparse(value _v_closure, value _v_buf, value _v_no)
+{ return camlidl_cudd_abdd_iter_cube_buf(true,true,_v_closure,_v_buf,_v_no); }
+value camlidl_cudd_avdd_iter_cube_str(value _v_closure, value _v_buf, value _v_no)
+{ return camlidl_cudd_abdd_iter_cube_buf(false,false,_v_closure,_v_buf,_v_no); }
+value camlidl_cudd_avdd_iter_cube_sparse(value _v_closure, value _v_buf, value _v_no)
+{ return camlidl_cudd_abdd_iter_cube_buf(false,true,_v_closure,_v_buf,_v_no); }
+
+value camlidl_cudd_abdd_iter_cube_buf(bool bdd, bool sparse, value _v_closure, value _v_buf, value _v_no)
+{
+  CAMLparam3(_v_closure,_v_buf,_v_no); CAMLlocal1(_v_val);
+  bdd__t no;
+  DdGen* gen;
+  int* array;
+  double val;
+  int size,n;
+  int autodyn;
+  Cudd_ReorderingType heuristic;
+
+  camlidl_cudd_node_ml2c(_v_no,&no);
+  size = no.man->man->size;
+  camlidl_cudd_check_buf(sparse,_v_buf,size,
+			 "Bdd.iter_cube_str/sparse: buffer smaller than the number of variables");
+  autodyn = 0;
+  if (Cudd_ReorderingStatus(no.man->man,&heuristic)){
+    autodyn = 1;
+    Cudd_AutodynDisable(no.man->man);
+  }
+  Cudd_ForeachCube(no.man->man,no.node,gen,array,val)
+    {
+      n = camlidl_cudd_fill_buf(sparse,_v_buf,array,size);
+      if (bdd){
+	if (sparse)
+	  caml_callback2(_v_closure,_v_buf,Val_int(n));
+	else
+	  caml_callback(_v_closure,_v_buf);
+      }
+      else {
+	if (no.man->caml){
+	  CuddauxType type;
+	  type.dbl = val;
+	  _v_val = type.value;
+	}
+	else {
+	  _v_val = copy_double(val);
+	}
+	if (sparse)
+	  caml_callback3(_v_closure,_v_buf,Val_int(n),_v_val);
+	else
+	  caml_callback2(_v_closure,_v_buf,_v_val);
+      }
+    }
+  if (autodyn) Cudd_AutodynEnable(no.man->man,CUDD_REORDER_SAME);
+  CAMLreturn(Val_unit);
+}
+
+value camlidl_cudd_bdd_iter_prime_str(value _v_closure, value _v_buf, value _v_lower, value _v_upper)
+{ return camlidl_cudd_bdd_iter_prime_buf(false,_v_closure,_v_buf,_v_lower,_v_upper); }
+value camlidl_cudd_bdd_iter_prime_sparse(value _v_closure, value _v_buf, value _v_lower, value _v_upper)
+{ return camlidl_cudd_bdd_iter_prime_buf(true,_v_closure,_v_buf,_v_lower,_v_upper); }
+
+value camlidl_cudd_bdd_iter_prime_buf(bool sparse, value _v_closure, value _v_buf, value _v_lower, value _v_upper)
+{
+  CAMLparam4(_v_closure,_v_buf,_v_lower,_v_upper);
+  bdd__t lower,upper;
+  DdGen* gen;
+  int* array;
+  int size,n;
+  int autodyn;
+  Cudd_ReorderingType heuristic;
+
+  camlidl_cudd_node_ml2c(_v_lower,&lower);
+  camlidl_cudd_node_ml2c(_v_upper,&upper);
+  if (lower.man!=upper.man){
+    caml_invalid_argument("Bdd.iter_prime_str/sparse called with BDDs belonging to different managers !");
+  }
+  size = lower.man->man->size;
+  camlidl_cudd_check_buf(sparse,_v_buf,size,
+			 "Bdd.iter_prime_str/sparse: buffer smaller than the number of variables");
+  autodyn = 0;
+  if (Cudd_ReorderingStatus(lower.man->man,&heuristic)){
+    autodyn = 1;
+    Cudd_AutodynDisable(lower.man->man);
+  }
+  Cudd_ForeachPrime(lower.man->man,lower.node,upper.node,gen,array)
+    {
+      n = camlidl_cudd_fill_buf(sparse,_v_buf,array,size);
+      if (sparse)
+	caml_callback2(_v_closure,_v_buf,Val_int(n));
+      else
+	caml_callback(_v_closure,_v_buf);
+    }
+  if (autodyn) Cudd_AutodynEnable(lower.man->man,CUDD_REORDER_SAME);
+  CAMLreturn(Val_unit);
+}
+
+/* %======================================================================== */
+/* \section{Export of cubes} */
+/* %======================================================================== */
+
+/* The cubes of a diagram are written to a file descriptor in the following
+   binary format, where integers are 32 bits unsigned integers and doubles
+   are in the byte order of the machine:
+
+   - header: the 8 characters "CUDDCUBE", then 4 integers: the version of the
+     format (1), the encoding of cubes (0: dense, 1: sparse), the kind of
+     leaves (0: none, 1: double, 2: index of leaf), and the number of
+     variables n;
+
+   - for each cube: in dense encoding, (n+3)/4 bytes, the value of variable i
+     being in bits 2*(i mod 4) and 2*(i mod 4)+1 of byte i/4 (0: false, 1:
+     true, 2: don't care); in sparse encoding, an integer m followed by m
+     integers (index lsl 1) lor phase; then the leaf, if any, as a double or
+     as an integer (index of the leaf in the array returned by
+     [Vdd.write_cubes]).
+
+   Cubes are buffered, so that OCaml is not involved at all during the
+   enumeration. */
+
+#define CAMLIDL_CUDD_WRITER_SIZE 65536
+
+struct camlidl_cudd_writer {
+  int fd;
+  int error; /* errno of the first failed write, 0 otherwise */
+  size_t pos;
+  unsigned char buf[CAMLIDL_CUDD_WRITER_SIZE];
+};
+
+/* data is not in the OCaml heap, so that other threads may run during
+   the write */
+static void camlidl_cudd_writer_write(struct camlidl_cudd_writer* w, const unsigned char* data, size_t size)
+{
+  ssize_t n;
+  int err;
+  while (size>0 && w->error==0){
+    caml_enter_blocking_section();
+    n = write(w->fd,data,size);
+    err = errno;
+    caml_leave_blocking_section();
+    if (n<0){
+      if (err!=EINTR) w->error = err;
+    }
+    else {
+      data += n;
+      size -= n;
+    }
+  }
+}
+static void camlidl_cudd_writer_flush(struct camlidl_cudd_writer* w)
+{
+  camlidl_cudd_writer_write(w,w->buf,w->pos);
+  w->pos = 0;
+}
+static void camlidl_cudd_writer_put(struct camlidl_cudd_writer* w, const void* data, size_t size)
+{
+  if (w->pos+size > CAMLIDL_CUDD_WRITER_SIZE){
+    camlidl_cudd_writer_flush(w);
+    if (size > CAMLIDL_CUDD_WRITER_SIZE){
+      camlidl_cudd_writer_write(w,data,size);
+      return;
+    }
+  }
+  memcpy(w->buf+w->pos,data,size);
+  w->pos += size;
+}
+static void camlidl_cudd_writer_put_int(struct camlidl_cudd_writer* w, uint32_t n)
+{
+  camlidl_cudd_writer_put(w,&n,sizeof(uint32_t));
+}
+
+value camlidl_cudd_bdd_write_cubes(value _v_sparse, value _v_fd, value _v_no)
+{ return camlidl_cudd_abdd_write_cubes(0,_v_sparse,_v_fd,_v_no); }
+value camlidl_cudd_add_write_cubes(value _v_sparse, value _v_fd, value _v_no)
+{ return camlidl_cudd_abdd_write_cubes(1,_v_sparse,_v_fd,_v_no); }
+value camlidl_cudd_vdd_write_cubes(value _v_sparse, value _v_fd, value _v_no)
+{ return camlidl_cudd_abdd_write_cubes(2,_v_sparse,_v_fd,_v_no); }
+
+/* kind is 0 for BDDs, 1 for ADDs (the double leaf is written), and 2 for
+   VDDs (the index of the leaf is written, and the array of leaves is
+   returned) */
+value camlidl_cudd_abdd_write_cubes(int kind, value _v_sparse, value _v_fd, value _v_no)
+{
+  CAMLparam3(_v_sparse,_v_fd,_v_no); CAMLlocal1(_v_res);
+  bdd__t no;
+  DdManager* dd;
+  DdGen* gen;
+  int* array;
+  int* inputs = NULL;
+  double val;
+  int size,i,n,autodyn,error;
+  bool sparse;
+  Cudd_ReorderingType heuristic;
+  struct camlidl_cudd_writer* w;
+  unsigned char* cube;
+  uint32_t* scube;
+  st_table* tleaf = NULL;
+  DdNode** leaves = NULL;
+  int nleaves = 0, maxleaves = 0;
+
+  camlidl_cudd_node_ml2c(_v_no,&no);
+  dd = no.man->man;
+  sparse = Bool_val(_v_sparse);
+  size = dd->size;
+  w = (struct camlidl_cudd_writer*)malloc(sizeof(struct camlidl_cudd_writer));
+  cube = (unsigned char*)malloc((size+3)/4+1);
+  scube = (uint32_t*)malloc((size+1)*sizeof(uint32_t));
+  if (kind==2){
+    tleaf = st_init_table(st_ptrcmp,st_ptrhash);
+    inputs = (int*)malloc((size+1)*sizeof(int));
+  }
+  if (w==NULL || cube==NULL || scube==NULL ||
+      (kind==2 && (tleaf==NULL || inputs==NULL))){
+    free(w); free(cube); free(scube); free(inputs);
+    if (tleaf) st_free_table(tleaf);
+    caml_failwith("write_cubes: out of memory");
+  }
+  w->fd = Int_val(_v_fd);
+  w->error = 0;
+  w->pos = 0;
+  camlidl_cudd_writer_put(w,"CUDDCUBE",8);
+  camlidl_cudd_writer_put_int(w,1);
+  camlidl_cudd_writer_put_int(w,sparse ? 1 : 0);
+  camlidl_cudd_writer_put_int(w,kind);
+  camlidl_cudd_writer_put_int(w,size);
+
+  autodyn = 0;
+  if (Cudd_ReorderingStatus(dd,&heuristic)){
+    autodyn = 1;
+    Cudd_AutodynDisable(dd);
+  }
+  error = 0;
+  gen = Cudd_FirstCube(dd,no.node,&array,&val);
+  while (!Cudd_IsGenEmpty(gen) && w->error==0 && error==0){
+    if (sparse){
+      n = 0;
+      for (i=0; i<size; i++){
+	if (array[i]!=2) scube[1+n++] = (i<<1) | array[i];
+      }
+      scube[0] = n;
+      camlidl_cudd_writer_put(w,scube,(n+1)*sizeof(uint32_t));
+    }
+    else {
+      memset(cube,0,(size+3)/4);
+      for (i=0; i<size; i++){
+	cube[i/4] |= array[i] << (2*(i%4));
+      }
+      camlidl_cudd_writer_put(w,cube,(size+3)/4);
+    }
+    if (kind==1){
+      camlidl_cudd_writer_put(w,&val,sizeof(double));
+    }
+    else if (kind==2){
+      /* the leaf reached by the current cube, found by evaluating the
+	 diagram on one of its minterms */
+      DdNode* leaf;
+      for (i=0; i<size; i++)
+	inputs[i] = array[i]==1;
+      leaf = Cudd_Regular(Cudd_Eval(dd,no.node,inputs));
+      if (!st_lookup_int(tleaf,(char*)leaf,&n)){
+	if (nleaves==maxleaves){
+	  DdNode** nleaves2;
+	  maxleaves = maxleaves==0 ? 16 : 2*maxleaves;
+	  nleaves2 = (DdNode**)realloc(leaves,maxleaves*sizeof(DdNode*));
+	  if (nleaves2==NULL){ error = 1; break; }
+	  leaves = nleaves2;
+	}
+	n = nleaves;
+	leaves[nleaves++] = leaf;
+	if (st_insert(tleaf,(char*)leaf,(char*)(ptrint)n)==ST_OUT_OF_MEM){
+	  error = 1; break;
+	}
+      }
+      camlidl_cudd_writer_put_int(w,n);
+    }
+    Cudd_NextCube(gen,&array,&val);
+  }
+  Cudd_GenFree(gen);
+  if (w->error==0) camlidl_cudd_writer_flush(w);
+  if (autodyn) Cudd_AutodynEnable(dd,CUDD_REORDER_SAME);
+  free(cube);
+  free(scube);
+  free(inputs);
+  if (tleaf) st_free_table(tleaf);
+  if (w->error!=0 || error!=0){
+    sprintf(camlidl_cudd_msg,"write_cubes: %s",
+	    error!=0 ? "out of memory" : strerror(w->error));
+    free(w);
+    free(leaves);
+    caml_failwith(camlidl_cudd_msg);
+  }
+  free(w);
+  if (kind==2){
+    _v_res = nleaves==0 ? Atom(0) : caml_alloc(nleaves,0);
+    for (i=0; i<nleaves; i++){
+      Store_field(_v_res,i,Val_DdNode(no.man->caml,leaves[i]));
+    }
+    free(leaves);
+  }
+  else {
+    _v_res = Val_unit;
+  }
+  CAMLreturn(_v_res);
+}
+
+/* %======================================================================== */
+/* \section{Cubes} */
+/* %======================================================================== */
+
+value camlidl_cudd_cube_of_bdd(value _v_no)
+{
+  CAMLparam1(_v_no); CAMLlocal1(_v_res);
+  node__t no;
+  bdd__t _res;
+  camlidl_cudd_node_ml2c(_v_no,&no);
+  _res.man = no.man;
+  _res.node = Cudd_FindEssential(no.man->man,no.node);
+  _v_res = camlidl_cudd_bdd_c2ml(&_res);
+  CAMLreturn(_v_res);
+}
+
+value camlidl_cudd_cube_of_minterm(value _v_man, value _v_array)
+{
+  CAMLparam2(_v_man,_v_array); CAMLlocal1(_v_res);
+  struct CuddauxMan* man;
+  int i,size,maxsize;
+  int* array;
+  bdd__t _res;
+
+  camlidl_cudd_man_ml2c(_v_man, &man);
+  size = Wosize_val(_v_array);
+  maxsize = Cudd_ReadSize(man->man);
+  if (size>maxsize){
+    caml_invalid_argument("Bdd.cube_of_minterm: array of size greater than the number of variables in manager");
   }
   array = malloc(maxsize*sizeof(int));
   for (i=0; i<size; i++){
@@ -1345,6 +2463,7 @@ value camlidl_cudd_pick_cubes_on_support(value _v_no1, value _v_no2, value _v_k)
   array = Cudd_bddPickArbitraryMinterms(no1.man->man,no1.node,vars,size,k);
   free(vars);
   if (array==NULL){
+    camlidl_cudd_check_error(no1.man->man,"Bdd.pick_cubes_on_support");
     caml_failwith("Bdd.pick_cubes_on_support: out of memory, or first argument is false, or wrong support, or number of minterms < k");
   }
 
@@ -1395,9 +2514,9 @@ value camlidl_cudd_avdd_nodes_below_level(value _v_no, value _v_olevel, value _v
   CAMLparam3(_v_no,_v_olevel,_v_omax);
   CAMLlocal2(res,v);
   node__t no;
-  int i,level;
-  size_t max,size;
-  cuddaux_list_t *p, *list;
+  int level;
+  size_t i,max,size;
+  DdNode** tab;
 
   camlidl_cudd_node_ml2c(_v_no,&no);
   if (Is_long(_v_olevel))
@@ -1412,7 +2531,7 @@ value camlidl_cudd_avdd_nodes_below_level(value _v_no, value _v_olevel, value _v
     value _v_max = Field(_v_omax,0);
     max = Int_val(_v_max);
   }
-  list = Cuddaux_NodesBelowLevel(no.man->man,no.node,level,max,&size,!no.man->caml);
+  tab = Cuddaux_NodesBelowLevel(no.man->man,no.node,level,max,&size,!no.man->caml);
 
   /* Create and fill the array */
   if (size==0){
@@ -1420,14 +2539,14 @@ value camlidl_cudd_avdd_nodes_below_level(value _v_no, value _v_olevel, value _v
   }
   else {
     res = caml_alloc(size,0);
-    for(p=list, i=0; p!=NULL; p=p->next,i++){
-      assert(p->node->ref>=1);
-      no.node = p->node;
+    for (i=0; i<size; i++){
+      assert(tab[i]->ref>=1);
+      no.node = tab[i];
       v = camlidl_cudd_node_c2ml(&no);
       Store_field(res,i,v);
     }
+    free(tab);
   }
-  cuddaux_list_free(list);
   CAMLreturn(res);
 }
 
@@ -1436,33 +2555,83 @@ value camlidl_cudd_avdd_leaves(value _v_no)
 {
   CAMLparam1(_v_no); CAMLlocal1(res);
   node__t no;
-  cuddaux_list_t *p, *list;
-  int i;
-  size_t size;
+  DdNode** tab;
+  size_t i,size;
 
   camlidl_cudd_node_ml2c(_v_no,&no);
-  list = Cuddaux_NodesBelowLevel(no.man->man,no.node,CUDD_MAXINDEX,0,&size,!no.man->caml);
+  tab = Cuddaux_NodesBelowLevel(no.man->man,no.node,CUDD_MAXINDEX,0,&size,!no.man->caml);
 
   /* Create and fill the array */
   if (size==0){
     res = Atom(0);
   }
   else {
-    res =
-      no.man->caml ?
-      caml_alloc(size,0) :
-      caml_alloc(size * Double_wosize,Double_array_tag);
-      ;
-      for(p=list,i=0; p!=NULL; p=p->next,i++){
-	if (no.man->caml){
-	  Store_field(res,i,cuddauxCamlV(p->node));
-	}
-	else {
-	  Store_double_field(res,i,cuddV(p->node));
-	}
+    if (no.man->caml){
+      /* Leaves are distinct nodes, hence distinct OCaml values, and
+	 are kept alive by no, so that the array can be filled
+	 without any allocation */
+      res = caml_alloc(size,0);
+      for (i=0; i<size; i++){
+	Store_field(res,i,cuddauxCamlV(tab[i]));
       }
+    }
+    else {
+      res = caml_alloc(size * Double_wosize,Double_array_tag);
+      for (i=0; i<size; i++){
+	Store_double_field(res,i,cuddV(tab[i]));
+      }
+    }
+    free(tab);
+  }
+  CAMLreturn(res);
+}
+
+/* Leaves of an add or vdd together with their guards, computed in a
+   single traversal. */
+value camlidl_cudd_avdd_guardleafs(value _v_no)
+{
+  CAMLparam1(_v_no); CAMLlocal4(res,pair,vguard,vleaf);
+  node__t no;
+  bdd__t guard;
+  DdNode **leaves, **guards;
+  size_t i,size;
+
+  camlidl_cudd_node_ml2c(_v_no,&no);
+  if (!Cuddaux_addGuardLeafs(no.man->man,no.node,!no.man->caml,
+			     &leaves,&guards,&size)){
+    camlidl_cudd_check_error(no.man->man,"Dd.guardleafs");
+    caml_failwith("Dd.guardleafs: out of memory");
+  }
+  if (size==0){
+    res = Atom(0);
+  }
+  else {
+    /* First wrap all the guards, which are referenced by
+       Cuddaux_addGuardLeafs and are protected once wrapped */
+    res = caml_alloc(size,0);
+    for (i=0; i<size; i++){
+      Store_field(res,i,Val_unit);
+    }
+    guard.man = no.man;
+    for (i=0; i<size; i++){
+      guard.node = guards[i];
+      vguard = camlidl_cudd_bdd_c2ml(&guard);
+      cuddDeref(guards[i]);
+      pair = caml_alloc_small(2,0);
+      Field(pair,0) = vguard;
+      Field(pair,1) = Val_unit;
+      Store_field(res,i,pair);
+    }
+    for (i=0; i<size; i++){
+      vleaf =
+	no.man->caml ?
+	cuddauxCamlV(leaves[i]) :
+	caml_copy_double(cuddV(leaves[i]));
+      Store_field(Field(res,i),1,vleaf);
+    }
   }
-  cuddaux_list_free(list);
+  free(leaves);
+  free(guards);
   CAMLreturn(res);
 }
 
@@ -1471,18 +2640,18 @@ value camlidl_cudd_avdd_pick_leaf(value _v_no)
 {
   CAMLparam1(_v_no); CAMLlocal1(res);
   node__t no;
-  cuddaux_list_t *list;
+  DdNode** tab;
+  DdNode* node;
   size_t size;
 
   camlidl_cudd_node_ml2c(_v_no,&no);
-  list = Cuddaux_NodesBelowLevel(no.man->man,no.node,CUDD_MAXINDEX,1,&size,!no.man->caml);
-  if (list==NULL){
+  tab = Cuddaux_NodesBelowLevel(no.man->man,no.node,CUDD_MAXINDEX,1,&size,!no.man->caml);
+  if (tab==NULL){
     caml_invalid_argument("A Mtbdd should never contain the CUDD background node !");
   }
-  else {
-    res = Val_DdNode(no.man->caml,list->node);
-   }
-  cuddaux_list_free(list);
+  node = tab[0];
+  free(tab);
+  res = Val_DdNode(no.man->caml,node);
   CAMLreturn(res);
 }
 
@@ -1549,6 +2718,7 @@ DdNode* camlidl_cudd_custom_op1(DdManager* dd, struct op1* op, DdNode* f)
   if (cuddIsConstant(f)){
     CuddauxType type;
     _v_f = Val_DdNode(op->common1.man->caml,f);
+    cuddauxProfileCallback(&op->common1,1);
     _v_val = caml_callback_exn(op->closure1, _v_f);
     res = camlidl_cudd_custom_result(&op->common1,_v_val);
   }
@@ -1578,6 +2748,7 @@ DdNode* camlidl_cudd_custom_op2(DdManager* dd, struct op2* op,
 	  _v_F = copy_double(cuddV(F));
 	  _v_G = copy_double(cuddV(G));
 	}
+	cuddauxProfileCallback(&op->common2,1);
 	_v_val = caml_callback2_exn(op->closure2, _v_F, _v_G);
 	res = camlidl_cudd_custom_result(&op->common2,_v_val);
       } End_roots();
@@ -1588,6 +2759,7 @@ DdNode* camlidl_cudd_custom_op2(DdManager* dd, struct op2* op,
 	noG.man = op->common2.man; noG.node = G;
 	_v_F = camlidl_cudd_node_c2ml(&noF);
 	_v_G = camlidl_cudd_node_c2ml(&noG);
+	cuddauxProfileCallback(&op->common2,1);
 	_v_val = Field(op->ospecial2,0);
 	_v_val = caml_callback2_exn(_v_val,_v_F,_v_G);
 	if (Is_exception_result(_v_val)){
@@ -1629,6 +2801,7 @@ DdNode* camlidl_cudd_custom_op3(DdManager* dd, struct op3* op, DdNode* F, DdNode
 	  _v_G = copy_double(cuddV(G));
 	  _v_H = copy_double(cuddV(H));
 	}
+	cuddauxProfileCallback(&op->common3,1);
 	_v_val = caml_callback3_exn(op->closure3,_v_F,_v_G,_v_H);
 	res = camlidl_cudd_custom_result(&op->common3,_v_val);
       } End_roots();
@@ -1641,6 +2814,7 @@ DdNode* camlidl_cudd_custom_op3(DdManager* dd, struct op3* op, DdNode* F, DdNode
 	_v_F = camlidl_cudd_node_c2ml(&noF);
 	_v_G = camlidl_cudd_node_c2ml(&noG);
 	_v_H = camlidl_cudd_node_c2ml(&noH);
+	cuddauxProfileCallback(&op->common3,1);
 	_v_val = Field(op->ospecial3,0);
 	_v_val = caml_callback3_exn(_v_val,_v_F,_v_G,_v_H);
 	if (Is_exception_result(_v_val)){
@@ -1681,6 +2855,7 @@ DdNode* camlidl_cudd_custom_test2(DdManager* dd, struct test2* op, DdNode* F, Dd
 	  _v_F = copy_double(cuddV(F));
 	  _v_G = copy_double(cuddV(G));
 	}
+	cuddauxProfileCallback(&op->common2t,1);
 	_v_val = caml_callback2_exn(op->closure2t, _v_F, _v_G);
 	res = camlidl_cudd_custom_resultbool(&op->common2t,_v_val);
       } End_roots();
@@ -1691,6 +2866,7 @@ DdNode* camlidl_cudd_custom_test2(DdManager* dd, struct test2* op, DdNode* F, Dd
 	noG.man = op->common2t.man; noG.node = G;
 	_v_F = camlidl_cudd_node_c2ml(&noF);
 	_v_G = camlidl_cudd_node_c2ml(&noG);
+	cuddauxProfileCallback(&op->common2t,1);
 	_v_val = Field(op->ospecial2t,0);
 	_v_val = caml_callback2_exn(_v_val,_v_F,_v_G);
 	if (Is_exception_result(_v_val)){
@@ -1732,6 +2908,7 @@ DdNode* camlidl_cudd_custom_opNG(DdManager* dd, struct opN* op, DdNode** tnode)
     Begin_roots3(_v_tno1,_v_tno2,_v_val){
       _v_tno1 = camlidl_cudd_tnode_c2ml(op->commonN.man,tnode,arityB);
       _v_tno2 = camlidl_cudd_tnode_c2ml(op->commonN.man,tnode+arityB,arityV);
+      cuddauxProfileCallback(&op->commonN,1);
       _v_val = caml_callback2_exn(op->closureN,_v_tno1,_v_tno2);
       if (Is_exception_result(_v_val)){
 	op->commonN.exn = Extract_exception(_v_val);
@@ -1769,6 +2946,7 @@ int camlidl_cudd_custom_opGbeforeRec(DdManager* dd, struct opG* op, DdNode* no,
   _v_tno1 = camlidl_cudd_tnode_c2ml(op->commonG.man,tnode,arityB);
   _v_tno2 = camlidl_cudd_tnode_c2ml(op->commonG.man,tnode+arityB,arityV);
   assert(Is_block(op->oclosureBeforeRec));
+  cuddauxProfileCallback(&op->commonG,1);
   _v_val = Field(op->oclosureBeforeRec,0);
   _v_val = caml_callback3_exn(_v_val,_v_pair,_v_tno1,_v_tno2);
   if (Is_exception_result(_v_val)){
@@ -1824,6 +3002,7 @@ DdNode* camlidl_cudd_custom_opGite(DdManager* dd, struct opG* op, int index, DdN
   no2.node = E;
   _v_no1 = camlidl_cudd_node_c2ml(&no1);
   _v_no2 = camlidl_cudd_node_c2ml(&no2);
+  cuddauxProfileCallback(&op->commonG,1);
   _v_val = Field(op->oclosureIte,0);
   _v_no = caml_callback3_exn(_v_val,Val_int(index),_v_no1,_v_no2);
   if (Is_exception_result(_v_no)){
@@ -1835,3 +3014,1114 @@ DdNode* camlidl_cudd_custom_opGite(DdManager* dd, struct opG* op, int index, DdN
   }
   CAMLreturnT(DdNode*,res);
 }
+
+/* %======================================================================== */
+/* \section{Storage and loading (DDDMP)} */
+/* %======================================================================== */
+
+/* Forests of BDDs or ADDs are stored with DDDMP in a single file, so that
+   nodes shared between the roots are written once. Variables are
+   identified by their index, both when storing and when loading. */
+
+value camlidl_cudd_abdd_store(bool bdd, value _v_binary, value _v_filename, value _v_vec)
+{
+  CAMLparam3(_v_binary,_v_filename,_v_vec);
+  DdNode** vec;
+  man__t man;
+  int size,mode,res;
+
+  size = Wosize_val(_v_vec);
+  if (size==0)
+    caml_invalid_argument("Dd.store: empty array (annoying because unknown manager)");
+  vec = (DdNode**)malloc(size * sizeof(DdNode*));
+  if (vec==NULL)
+    caml_failwith("Dd.store: out of memory");
+  man = camlidl_cudd_tnode_ml2c(_v_vec,size,vec);
+  if (man==NULL){
+    free(vec);
+    caml_invalid_argument("Dd.store: the nodes do not belong to the same manager");
+  }
+  mode = Bool_val(_v_binary) ? DDDMP_MODE_BINARY : DDDMP_MODE_TEXT;
+  if (bdd)
+    res = Dddmp_cuddBddArrayStore(man->man,NULL,size,vec,NULL,NULL,NULL,
+				  mode,DDDMP_VARIDS,
+				  (char*)String_val(_v_filename),NULL);
+  else
+    res = Dddmp_cuddAddArrayStore(man->man,NULL,size,vec,NULL,NULL,NULL,
+				  mode,DDDMP_VARIDS,
+				  (char*)String_val(_v_filename),NULL);
+  free(vec);
+  if (res!=DDDMP_SUCCESS){
+    snprintf(camlidl_cudd_msg,sizeof(camlidl_cudd_msg),
+	     "Dd.store: cannot store into file %s",String_val(_v_filename));
+    caml_failwith(camlidl_cudd_msg);
+  }
+  CAMLreturn(Val_unit);
+}
+value camlidl_cudd_bdd_store(value _v_binary, value _v_filename, value _v_vec)
+{
+  return camlidl_cudd_abdd_store(true,_v_binary,_v_filename,_v_vec);
+}
+value camlidl_cudd_add_store(value _v_filename, value _v_vec)
+{
+  /* DDDMP does not support the binary mode for ADDs */
+  return camlidl_cudd_abdd_store(false,Val_false,_v_filename,_v_vec);
+}
+
+value camlidl_cudd_abdd_load(bool bdd, value _v_man, value _v_filename)
+{
+  CAMLparam2(_v_man,_v_filename); CAMLlocal2(_v_res,_v_no);
+  man__t man;
+  DdNode** roots;
+  node__t no;
+  int i,size;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  roots = NULL;
+  if (bdd)
+    size = Dddmp_cuddBddArrayLoad(man->man,DDDMP_ROOT_MATCHLIST,NULL,
+				  DDDMP_VAR_MATCHIDS,NULL,NULL,NULL,
+				  DDDMP_MODE_DEFAULT,
+				  (char*)String_val(_v_filename),NULL,&roots);
+  else
+    size = Dddmp_cuddAddArrayLoad(man->man,DDDMP_ROOT_MATCHLIST,NULL,
+				  DDDMP_VAR_MATCHIDS,NULL,NULL,NULL,
+				  DDDMP_MODE_DEFAULT,
+				  (char*)String_val(_v_filename),NULL,&roots);
+  if (size<=0 || roots==NULL){
+    snprintf(camlidl_cudd_msg,sizeof(camlidl_cudd_msg),
+	     "Dd.load: cannot load file %s",String_val(_v_filename));
+    if (roots!=NULL) free(roots);
+    caml_failwith(camlidl_cudd_msg);
+  }
+  for (i=0; i<size; i++){
+    if (roots[i]==NULL){
+      for (i=0; i<size; i++)
+	if (roots[i]!=NULL) Cudd_RecursiveDeref(man->man,roots[i]);
+      free(roots);
+      caml_failwith("Dd.load: NULL root found in file");
+    }
+  }
+  /* The roots are returned referenced by DDDMP; the references are
+     transferred to the OCaml values. */
+  _v_res = caml_alloc(size,0);
+  no.man = man;
+  for (i=0; i<size; i++){
+    no.node = roots[i];
+    _v_no = bdd ? camlidl_cudd_bdd_c2ml(&no) : camlidl_cudd_node_c2ml(&no);
+    cuddDeref(roots[i]);
+    Store_field(_v_res,i,_v_no);
+  }
+  free(roots);
+  CAMLreturn(_v_res);
+}
+value camlidl_cudd_bdd_load(value _v_man, value _v_filename)
+{
+  return camlidl_cudd_abdd_load(true,_v_man,_v_filename);
+}
+value camlidl_cudd_add_load(value _v_man, value _v_filename)
+{
+  return camlidl_cudd_abdd_load(false,_v_man,_v_filename);
+}
+
+/* %======================================================================== */
+/* \section{Snapshots} */
+/* %======================================================================== */
+
+/* Read-only snapshots of BDD/ADD forests, mapped in memory (see
+   cuddauxSnapshot.c). A snapshot is wrapped in a custom block which
+   unmaps the file when collected. */
+
+#define Snapshot_val(v) (*((struct CuddauxSnapshot**)(Data_custom_val(v))))
+
+void camlidl_custom_snapshot_finalize(value val)
+{
+  Cuddaux_SnapshotClose(Snapshot_val(val));
+}
+int camlidl_custom_snapshot_compare(value val1, value val2)
+{
+  struct CuddauxSnapshot* snap1 = Snapshot_val(val1);
+  struct CuddauxSnapshot* snap2 = Snapshot_val(val2);
+  return (snap1==snap2 ? 0 : (snap1<snap2 ? -1 : 1));
+}
+long camlidl_custom_snapshot_hash(value val)
+{
+  return (long)Snapshot_val(val);
+}
+struct custom_operations camlidl_custom_snapshot = {
+  "camlidl_cudd_custom_snapshot",
+  &camlidl_custom_snapshot_finalize,
+  &camlidl_custom_snapshot_compare,
+  &camlidl_custom_snapshot_hash,
+  custom_serialize_default,
+  custom_deserialize_default,
+  custom_compare_ext_default
+};
+
+value camlidl_cudd_abdd_write_snapshot(bool bdd, value _v_filename, value _v_vec)
+{
+  CAMLparam2(_v_filename,_v_vec);
+  DdNode** vec;
+  man__t man;
+  int size,res;
+
+  size = Wosize_val(_v_vec);
+  if (size==0)
+    caml_invalid_argument("Dd.write_snapshot: empty array (annoying because unknown manager)");
+  vec = (DdNode**)malloc(size * sizeof(DdNode*));
+  if (vec==NULL)
+    caml_failwith("Dd.write_snapshot: out of memory");
+  man = camlidl_cudd_tnode_ml2c(_v_vec,size,vec);
+  if (man==NULL){
+    free(vec);
+    caml_invalid_argument("Dd.write_snapshot: the nodes do not belong to the same manager");
+  }
+  if (!bdd && man->caml){
+    free(vec);
+    caml_invalid_argument("Dd.write_snapshot: ADDs with OCaml leaves are not supported");
+  }
+  res = Cuddaux_SnapshotWrite(man->man,!bdd,vec,size,String_val(_v_filename));
+  free(vec);
+  if (!res){
+    snprintf(camlidl_cudd_msg,sizeof(camlidl_cudd_msg),
+	     "Dd.write_snapshot: cannot write file %s",String_val(_v_filename));
+    caml_failwith(camlidl_cudd_msg);
+  }
+  CAMLreturn(Val_unit);
+}
+value camlidl_cudd_bdd_write_snapshot(value _v_filename, value _v_vec)
+{
+  return camlidl_cudd_abdd_write_snapshot(true,_v_filename,_v_vec);
+}
+value camlidl_cudd_add_write_snapshot(value _v_filename, value _v_vec)
+{
+  return camlidl_cudd_abdd_write_snapshot(false,_v_filename,_v_vec);
+}
+
+value camlidl_cudd_snapshot_open(value _v_filename)
+{
+  CAMLparam1(_v_filename); CAMLlocal1(_v_res);
+  struct CuddauxSnapshot* snap;
+
+  snap = Cuddaux_SnapshotOpen(String_val(_v_filename));
+  if (snap==NULL){
+    snprintf(camlidl_cudd_msg,sizeof(camlidl_cudd_msg),
+	     "Dd.open_snapshot: cannot map file %s, or malformed snapshot",
+	     String_val(_v_filename));
+    caml_failwith(camlidl_cudd_msg);
+  }
+  _v_res = caml_alloc_custom(&camlidl_custom_snapshot,sizeof(struct CuddauxSnapshot*),0,1);
+  Snapshot_val(_v_res) = snap;
+  CAMLreturn(_v_res);
+}
+
+value camlidl_cudd_snapshot_nroots(value _v_snap)
+{
+  return Val_int(Snapshot_val(_v_snap)->header->nroots);
+}
+
+/* Returns the edge to the root i, after checking the kind of the snapshot */
+static uint64_t camlidl_cudd_snapshot_root(bool bdd, value _v_snap, value _v_i)
+{
+  struct CuddauxSnapshot* snap = Snapshot_val(_v_snap);
+  int i = Int_val(_v_i);
+
+  if ((snap->header->add!=0) == bdd)
+    caml_invalid_argument(bdd ?
+			  "Bdd: the snapshot contains ADDs" :
+			  "Add: the snapshot contains BDDs");
+  if (i<0 || (uint32_t)i>=snap->header->nroots)
+    caml_invalid_argument("Dd: index of root out of bounds in snapshot");
+  return snap->roots[i];
+}
+
+value camlidl_cudd_abdd_snapshot_eval(bool bdd, value _v_snap, value _v_i, value _v_inputs)
+{
+  CAMLparam3(_v_snap,_v_i,_v_inputs); CAMLlocal1(_v_res);
+  struct CuddauxSnapshot* snap = Snapshot_val(_v_snap);
+  uint64_t edge;
+  int* inputs;
+  int i,size;
+
+  edge = camlidl_cudd_snapshot_root(bdd,_v_snap,_v_i);
+  size = Wosize_val(_v_inputs);
+  inputs = (int*)malloc((size>0 ? size : 1)*sizeof(int));
+  if (inputs==NULL)
+    caml_failwith("Dd.snapshot_eval: out of memory");
+  for (i=0; i<size; i++)
+    inputs[i] = Bool_val(Field(_v_inputs,i));
+  edge = Cuddaux_SnapshotEval(snap,edge,inputs,size);
+  free(inputs);
+  if (bdd)
+    _v_res = Val_bool(edge==0);
+  else
+    _v_res = caml_copy_double(snap->nodes[edge >> 1].type.dbl);
+  CAMLreturn(_v_res);
+}
+value camlidl_cudd_bdd_snapshot_eval(value _v_snap, value _v_i, value _v_inputs)
+{
+  return camlidl_cudd_abdd_snapshot_eval(true,_v_snap,_v_i,_v_inputs);
+}
+value camlidl_cudd_add_snapshot_eval(value _v_snap, value _v_i, value _v_inputs)
+{
+  return camlidl_cudd_abdd_snapshot_eval(false,_v_snap,_v_i,_v_inputs);
+}
+
+/* Enumerates the paths from edge to the constant nodes true (BDDs) or
+   different from 0.0 (ADDs), stopping at the first exception */
+static value camlidl_cudd_snapshot_iter_cube_recur(bool bdd,
+						   value _v_closure,
+						   const struct CuddauxSnapshot* snap,
+						   uint64_t edge, uint64_t compl,
+						   int* cube)
+{
+  CAMLparam1(_v_closure); CAMLlocal3(_v_array,_v_val,_v_res);
+  const struct CuddauxSnapshotNode* N = &snap->nodes[edge >> 1];
+  int i,size;
+
+  compl ^= edge & 1;
+  _v_res = Val_unit;
+  if (N->index==CUDD_CONST_INDEX){
+    if (bdd ? compl==0 : N->type.dbl!=0.0){
+      size = snap->header->nvars;
+      if (size==0)
+	_v_array = Atom(0);
+      else {
+	_v_array = caml_alloc(size,0);
+	for (i=0; i<size; i++)
+	  Store_field(_v_array,i,Val_int(cube[i]));
+      }
+      if (bdd)
+	_v_res = caml_callback_exn(_v_closure,_v_array);
+      else {
+	_v_val = caml_copy_double(N->type.dbl);
+	_v_res = caml_callback2_exn(_v_closure,_v_array,_v_val);
+      }
+    }
+  }
+  else {
+    cube[N->index] = 1;
+    _v_res = camlidl_cudd_snapshot_iter_cube_recur(bdd,_v_closure,snap,N->type.kids.T,compl,cube);
+    if (!Is_exception_result(_v_res)){
+      cube[N->index] = 0;
+      _v_res = camlidl_cudd_snapshot_iter_cube_recur(bdd,_v_closure,snap,N->type.kids.E,compl,cube);
+    }
+    cube[N->index] = 2;
+  }
+  CAMLreturn(_v_res);
+}
+
+value camlidl_cudd_abdd_snapshot_iter_cube(bool bdd, value _v_closure, value _v_snap, value _v_i)
+{
+  CAMLparam3(_v_closure,_v_snap,_v_i); CAMLlocal1(_v_res);
+  struct CuddauxSnapshot* snap = Snapshot_val(_v_snap);
+  uint64_t edge;
+  int* cube;
+  uint32_t i;
+
+  edge = camlidl_cudd_snapshot_root(bdd,_v_snap,_v_i);
+  cube = (int*)malloc((snap->header->nvars>0 ? snap->header->nvars : 1)*sizeof(int));
+  if (cube==NULL)
+    caml_failwith("Dd.snapshot_iter_cube: out of memory");
+  for (i=0; i<snap->header->nvars; i++)
+    cube[i] = 2;
+  _v_res = camlidl_cudd_snapshot_iter_cube_recur(bdd,_v_closure,snap,edge,0,cube);
+  free(cube);
+  if (Is_exception_result(_v_res))
+    caml_raise(Extract_exception(_v_res));
+  CAMLreturn(Val_unit);
+}
+value camlidl_cudd_bdd_snapshot_iter_cube(value _v_closure, value _v_snap, value _v_i)
+{
+  return camlidl_cudd_abdd_snapshot_iter_cube(true,_v_closure,_v_snap,_v_i);
+}
+value camlidl_cudd_add_snapshot_iter_cube(value _v_closure, value _v_snap, value _v_i)
+{
+  return camlidl_cudd_abdd_snapshot_iter_cube(false,_v_closure,_v_snap,_v_i);
+}
+
+value camlidl_cudd_abdd_of_snapshot(bool bdd, value _v_man, value _v_snap, value _v_i)
+{
+  CAMLparam3(_v_man,_v_snap,_v_i); CAMLlocal1(_v_res);
+  node__t no;
+  uint64_t edge;
+
+  edge = camlidl_cudd_snapshot_root(bdd,_v_snap,_v_i);
+  camlidl_cudd_man_ml2c(_v_man,&no.man);
+  if (!bdd && no.man->caml)
+    caml_invalid_argument("Add.of_snapshot: the manager supports OCaml leaves");
+  no.node = Cuddaux_SnapshotToDd(no.man->man,Snapshot_val(_v_snap),edge);
+  _v_res = bdd ? camlidl_cudd_bdd_c2ml(&no) : camlidl_cudd_node_c2ml(&no);
+  CAMLreturn(_v_res);
+}
+value camlidl_cudd_bdd_of_snapshot(value _v_man, value _v_snap, value _v_i)
+{
+  return camlidl_cudd_abdd_of_snapshot(true,_v_man,_v_snap,_v_i);
+}
+value camlidl_cudd_add_of_snapshot(value _v_man, value _v_snap, value _v_i)
+{
+  return camlidl_cudd_abdd_of_snapshot(false,_v_man,_v_snap,_v_i);
+}
+
+/* %======================================================================== */
+/* \section{Export and import of diagrams with OCaml leaves} */
+/* %======================================================================== */
+
+/* The structure of an array of VDDs is exported as a string, the leaves
+   being returned separately, so that they can be encoded in OCaml.
+
+   The string is the sequence of the internal nodes, children first. Each
+   node is written as 3 unsigned integers in base 128 (7 bits per byte, the
+   high bit set on all bytes but the last): the index of the variable, and
+   the references of its then and else children. A reference is
+   (i << 1) for the leaf i and (i << 1)|1 for the internal node i. The
+   roots are returned as an array of references. */
+
+struct camlidl_cudd_vbuf {
+  unsigned char* data;
+  size_t size;
+  size_t maxsize;
+};
+
+static bool camlidl_cudd_vbuf_put(struct camlidl_cudd_vbuf* buf, uint64_t n)
+{
+  if (buf->size+10 > buf->maxsize){
+    size_t maxsize = buf->maxsize==0 ? 4096 : 2*buf->maxsize;
+    unsigned char* data = realloc(buf->data,maxsize);
+    if (data==NULL) return false;
+    buf->data = data;
+    buf->maxsize = maxsize;
+  }
+  while (n >= 0x80){
+    buf->data[buf->size++] = (unsigned char)(n | 0x80);
+    n >>= 7;
+  }
+  buf->data[buf->size++] = (unsigned char)n;
+  return true;
+}
+static bool camlidl_cudd_vbuf_get(const unsigned char* data, size_t size,
+				  size_t* pos, uint64_t* pn)
+{
+  uint64_t n = 0;
+  int shift = 0;
+  while (*pos < size && shift < 64){
+    unsigned char c = data[(*pos)++];
+    n |= (uint64_t)(c & 0x7f) << shift;
+    if ((c & 0x80)==0){
+      *pn = n;
+      return true;
+    }
+    shift += 7;
+  }
+  return false;
+}
+
+/* Returns the reference of node, after having exported its descendants;
+   leaves are accumulated in leaves (allocated with size nleaves_max) */
+static bool camlidl_cudd_vdd_export_recur(DdNode* node, st_table* visited,
+					  struct camlidl_cudd_vbuf* buf,
+					  DdNode** leaves, size_t* pnleaves,
+					  size_t* pnnodes, uint64_t* pref)
+{
+  char* ref;
+  uint64_t T,E;
+
+  if (st_lookup(visited,(char*)node,&ref)){
+    *pref = (uint64_t)(uintptr_t)ref;
+    return true;
+  }
+  if (cuddIsConstant(node)){
+    leaves[*pnleaves] = node;
+    *pref = (uint64_t)(*pnleaves) << 1;
+    (*pnleaves)++;
+  }
+  else {
+    if (!camlidl_cudd_vdd_export_recur(cuddT(node),visited,buf,leaves,pnleaves,pnnodes,&T) ||
+	!camlidl_cudd_vdd_export_recur(cuddE(node),visited,buf,leaves,pnleaves,pnnodes,&E) ||
+	!camlidl_cudd_vbuf_put(buf,node->index) ||
+	!camlidl_cudd_vbuf_put(buf,T) ||
+	!camlidl_cudd_vbuf_put(buf,E))
+      return false;
+    *pref = ((uint64_t)(*pnnodes) << 1) | 1;
+    (*pnnodes)++;
+  }
+  return st_insert(visited,(char*)node,(char*)(uintptr_t)(*pref))!=ST_OUT_OF_MEM;
+}
+
+value camlidl_cudd_vdd_export(value _v_vec)
+{
+  CAMLparam1(_v_vec); CAMLlocal5(_v_res,_v_str,_v_roots,_v_leaves,_v_leaf);
+  struct camlidl_cudd_vbuf buf = { NULL, 0, 0 };
+  DdNode** vec;
+  DdNode** leaves;
+  st_table* visited;
+  man__t man;
+  size_t i,size,nleaves,nnodes;
+  uint64_t* roots;
+  bool ok;
+
+  size = Wosize_val(_v_vec);
+  if (size==0)
+    caml_invalid_argument("Vdd.export: empty array (annoying because unknown manager)");
+  vec = (DdNode**)malloc(size * sizeof(DdNode*));
+  roots = (uint64_t*)malloc(size * sizeof(uint64_t));
+  visited = st_init_table(st_ptrcmp,st_ptrhash);
+  if (vec==NULL || roots==NULL || visited==NULL){
+    if (vec!=NULL) free(vec);
+    if (roots!=NULL) free(roots);
+    if (visited!=NULL) st_free_table(visited);
+    caml_failwith("Vdd.export: out of memory");
+  }
+  man = camlidl_cudd_tnode_ml2c(_v_vec,size,vec);
+  if (man==NULL){
+    free(vec); free(roots); st_free_table(visited);
+    caml_invalid_argument("Vdd.export: the nodes do not belong to the same manager");
+  }
+  /* There are at most as many leaves as constants in the manager */
+  leaves = (DdNode**)malloc((man->man->constants.keys+1) * sizeof(DdNode*));
+  ok = leaves!=NULL;
+  nleaves = nnodes = 0;
+  for (i=0; ok && i<size; i++)
+    ok = camlidl_cudd_vdd_export_recur(vec[i],visited,&buf,leaves,&nleaves,&nnodes,&roots[i]);
+  free(vec);
+  st_free_table(visited);
+  if (!ok){
+    if (leaves!=NULL) free(leaves);
+    if (buf.data!=NULL) free(buf.data);
+    free(roots);
+    caml_failwith("Vdd.export: out of memory");
+  }
+  _v_str = caml_alloc_string(buf.size);
+  if (buf.size>0) memcpy(String_val(_v_str),buf.data,buf.size);
+  if (buf.data!=NULL) free(buf.data);
+  _v_roots = caml_alloc(size,0);
+  for (i=0; i<size; i++)
+    Store_field(_v_roots,i,Val_long(roots[i]));
+  free(roots);
+  _v_leaves = nleaves==0 ? Atom(0) : caml_alloc(nleaves,0);
+  for (i=0; i<nleaves; i++){
+    _v_leaf = Val_DdNode(man->caml,leaves[i]);
+    Store_field(_v_leaves,i,_v_leaf);
+  }
+  free(leaves);
+  _v_res = caml_alloc_tuple(3);
+  Store_field(_v_res,0,_v_str);
+  Store_field(_v_res,1,_v_roots);
+  Store_field(_v_res,2,_v_leaves);
+  CAMLreturn(_v_res);
+}
+
+value camlidl_cudd_vdd_import(value _v_man, value _v_leaves, value _v_str, value _v_roots)
+{
+  CAMLparam4(_v_man,_v_leaves,_v_str,_v_roots); CAMLlocal2(_v_res,_v_no);
+  struct CuddauxMan* man;
+  DdManager* dd;
+  DdNode** leaves;
+  DdNode** nodes;
+  size_t i,nleaves,nnodes,maxnodes,pos,size,nroots;
+  uint64_t index,ref[2];
+  DdNode* child[2];
+  DdNode *var,*res;
+  CuddauxType type;
+  node__t no;
+  const char* error = NULL;
+  int j;
+
+  camlidl_cudd_man_ml2c(_v_man,&man);
+  dd = man->man;
+  nleaves = Wosize_val(_v_leaves);
+  leaves = (DdNode**)malloc((nleaves>0 ? nleaves : 1)*sizeof(DdNode*));
+  nodes = NULL;
+  nnodes = maxnodes = 0;
+  if (leaves==NULL)
+    caml_failwith("Vdd.import: out of memory");
+  for (i=0; i<nleaves; i++){
+    type = Type_val(man->caml,Field(_v_leaves,i));
+    leaves[i] = cuddauxUniqueType(man,&type);
+    if (leaves[i]==NULL){ nleaves = i; error = "Vdd.import: out of memory"; goto import_end; }
+    cuddRef(leaves[i]);
+  }
+  pos = 0;
+  size = caml_string_length(_v_str);
+  while (pos<size){
+    if (!camlidl_cudd_vbuf_get((unsigned char*)String_val(_v_str),size,&pos,&index) ||
+	!camlidl_cudd_vbuf_get((unsigned char*)String_val(_v_str),size,&pos,&ref[0]) ||
+	!camlidl_cudd_vbuf_get((unsigned char*)String_val(_v_str),size,&pos,&ref[1]) ||
+	index>=CUDD_MAXINDEX){
+      error = "Vdd.import: malformed structure";
+      goto import_end;
+    }
+    for (j=0; j<2; j++){
+      uint64_t k = ref[j] >> 1;
+      if (ref[j] & 1 ? k>=nnodes : k>=nleaves){
+	error = "Vdd.import: malformed structure";
+	goto import_end;
+      }
+      child[j] = ref[j] & 1 ? nodes[k] : leaves[k];
+    }
+    if (nnodes==maxnodes){
+      size_t maxsize = maxnodes==0 ? 1024 : 2*maxnodes;
+      DdNode** tab = (DdNode**)realloc(nodes,maxsize*sizeof(DdNode*));
+      if (tab==NULL){ error = "Vdd.import: out of memory"; goto import_end; }
+      nodes = tab;
+      maxnodes = maxsize;
+    }
+    var = Cudd_bddIthVar(dd,(int)index);
+    res = var==NULL ? NULL : Cuddaux_addIte(dd,var,child[0],child[1]);
+    if (res==NULL){ error = "Vdd.import: out of memory"; goto import_end; }
+    cuddRef(res);
+    nodes[nnodes++] = res;
+  }
+  nroots = Wosize_val(_v_roots);
+  for (i=0; i<nroots; i++){
+    uint64_t r = Long_val(Field(_v_roots,i));
+    if (r & 1 ? (r>>1)>=nnodes : (r>>1)>=nleaves){
+      error = "Vdd.import: malformed roots";
+      goto import_end;
+    }
+  }
+  _v_res = nroots==0 ? Atom(0) : caml_alloc(nroots,0);
+  no.man = man;
+  for (i=0; i<nroots; i++){
+    uint64_t r = Long_val(Field(_v_roots,i));
+    no.node = r & 1 ? nodes[r>>1] : leaves[r>>1];
+    _v_no = camlidl_cudd_node_c2ml(&no);
+    Store_field(_v_res,i,_v_no);
+  }
+ import_end:
+  for (i=0; i<nnodes; i++)
+    Cudd_RecursiveDeref(dd,nodes[i]);
+  for (i=0; i<nleaves; i++)
+    Cudd_RecursiveDeref(dd,leaves[i]);
+  if (nodes!=NULL) free(nodes);
+  free(leaves);
+  if (error!=NULL){
+    camlidl_cudd_check_error(dd,"Vdd.import");
+    caml_failwith(error);
+  }
+  CAMLreturn(_v_res);
+}
+
+/* %======================================================================== */
+/* \section{Batched custom operations} */
+/* %======================================================================== */
+
+/* A batched operation first collects the tuples of nodes on which its
+   closure is needed (Cuddaux_addApplyCollect), then applies the closure to
+   all of them within a single call to OCaml, and finally performs the usual
+   recursion, in which terminal cases are looked up in the batch table. A
+   tuple missing from the table (for instance because it was hidden by an
+   entry of the memoization table that has been evicted since) falls back to
+   the unbatched callback. The tuples on which the special function declined
+   are recorded in the recursion table, so that it is called once only. */
+
+static int camlidl_cudd_batch_push(struct CuddauxBatch* batch, DdNode** tab)
+{
+  if (cuddauxBatchLookup(batch,tab)!=NULL) return 0;
+  return cuddauxBatchPush(batch,tab) ? 0 : -1;
+}
+
+static int camlidl_cudd_batch_visit_op1(DdManager* dd, void* env, DdNode** tab)
+{
+  struct op1* op = (struct op1*)env;
+  return
+    cuddIsConstant(tab[0]) ?
+    camlidl_cudd_batch_push(op->common1.batch,tab) :
+    1;
+}
+static int camlidl_cudd_batch_visit_op2(DdManager* dd, void* env, DdNode** tab)
+{
+  struct op2* op = (struct op2*)env;
+  DdNode* res;
+
+  if (op->idempotent && tab[0]==tab[1]) return 0;
+  if (cuddIsConstant(tab[0]) && cuddIsConstant(tab[1]))
+    return camlidl_cudd_batch_push(op->common2.batch,tab);
+  if ((cuddIsConstant(tab[0]) || cuddIsConstant(tab[1])) &&
+      op->ospecial2 != Val_int(0)){
+    res = camlidl_cudd_custom_op2(dd,op,tab[0],tab[1]);
+    if (res!=NULL)
+      return cuddauxBatchInsert(op->common2.batch,tab,res) ? 0 : -1;
+    else if (op->common2.exn!=Val_unit)
+      return -1;
+    /* the special function declined: it is not called again */
+    return cuddauxBatchRecurInsert(op->common2.batch,tab) ? 1 : -1;
+  }
+  return 1;
+}
+static int camlidl_cudd_batch_visit_op3(DdManager* dd, void* env, DdNode** tab)
+{
+  struct op3* op = (struct op3*)env;
+  DdNode* res;
+
+  if (cuddIsConstant(tab[0]) && cuddIsConstant(tab[1]) && cuddIsConstant(tab[2]))
+    return camlidl_cudd_batch_push(op->common3.batch,tab);
+  if ((cuddIsConstant(tab[0]) || cuddIsConstant(tab[1]) || cuddIsConstant(tab[2])) &&
+      op->ospecial3 != Val_int(0)){
+    res = camlidl_cudd_custom_op3(dd,op,tab[0],tab[1],tab[2]);
+    if (res!=NULL)
+      return cuddauxBatchInsert(op->common3.batch,tab,res) ? 0 : -1;
+    else if (op->common3.exn!=Val_unit)
+      return -1;
+    /* the special function declined: it is not called again */
+    return cuddauxBatchRecurInsert(op->common3.batch,tab) ? 1 : -1;
+  }
+  return 1;
+}
+static int camlidl_cudd_batch_visit_opN(DdManager* dd, void* env, DdNode** tab)
+{
+  struct opN* op = (struct opN*)env;
+  int i;
+
+  for (i=0; i<op->commonN.arity; i++){
+    if (Cudd_IsConstant(tab[i])) break;
+  }
+  if (i==op->commonN.arity || cuddauxBatchRecurLookup(op->commonN.batch,tab))
+    return 1;
+  return camlidl_cudd_batch_push(op->commonN.batch,tab);
+}
+
+/* Array of the j-th leaves of the pending tuples */
+static value camlidl_cudd_batch_leaves(bool caml, struct CuddauxBatch* batch, int j)
+{
+  CAMLparam0();
+  CAMLlocal1(_v_res);
+  size_t i;
+
+  if (caml){
+    _v_res = caml_alloc(batch->size,0);
+    for (i=0; i<batch->size; i++)
+      Store_field(_v_res,i,cuddauxCamlV(batch->pending[i*batch->arity+j]));
+  }
+  else {
+    _v_res = caml_alloc(batch->size*Double_wosize,Double_array_tag);
+    for (i=0; i<batch->size; i++)
+      Store_double_field(_v_res,i,cuddV(batch->pending[i*batch->arity+j]));
+  }
+  CAMLreturn(_v_res);
+}
+
+/* Applies the closure of an operation of arity 1, 2 or 3 to the pending
+   tuples, and stores the results in the batch table. Returns 0 if
+   successful, -1 otherwise. */
+static int camlidl_cudd_batch_call(struct common* common, value _v_closure)
+{
+  CAMLparam1(_v_closure);
+  CAMLlocal1(_v_res);
+  CAMLlocalN(_v_args,4);
+  static const char* name[3] = {
+    "camlidl_cudd_batch1","camlidl_cudd_batch2","camlidl_cudd_batch3"
+  };
+  struct CuddauxBatch* batch = common->batch;
+  CuddauxType type;
+  DdNode* res;
+  size_t i;
+  int j;
+  bool flat;
+
+  if (batch->size==0) CAMLreturnT(int,0);
+  _v_args[0] = _v_closure;
+  for (j=0; j<batch->arity; j++){
+    _v_res = camlidl_cudd_batch_leaves(common->man->caml,batch,j);
+    _v_args[j+1] = _v_res;
+  }
+  cuddauxProfileCallback(common,(long)batch->size);
+  _v_res = caml_callbackN_exn(*caml_named_value(name[batch->arity-1]),
+			      batch->arity+1,_v_args);
+  if (Is_exception_result(_v_res)){
+    common->exn = Extract_exception(_v_res);
+    CAMLreturnT(int,-1);
+  }
+  flat = Tag_val(_v_res)==Double_array_tag;
+  for (i=0; i<batch->size; i++){
+    if (common->man->caml)
+      type.value = flat ? caml_copy_double(Double_field(_v_res,i)) : Field(_v_res,i);
+    else
+      type.dbl = flat ? Double_field(_v_res,i) : Double_val(Field(_v_res,i));
+    res = cuddauxUniqueType(common->man,&type);
+    if (res==NULL ||
+	!cuddauxBatchInsert(batch,batch->pending+i*batch->arity,res))
+      CAMLreturnT(int,-1);
+  }
+  batch->size = 0;
+  CAMLreturnT(int,0);
+}
+static int camlidl_cudd_batch_call1(void* env)
+{
+  struct op1* op = (struct op1*)env;
+  return camlidl_cudd_batch_call(&op->common1,op->closure1);
+}
+static int camlidl_cudd_batch_call2(void* env)
+{
+  struct op2* op = (struct op2*)env;
+  return camlidl_cudd_batch_call(&op->common2,op->closure2);
+}
+static int camlidl_cudd_batch_call3(void* env)
+{
+  struct op3* op = (struct op3*)env;
+  return camlidl_cudd_batch_call(&op->common3,op->closure3);
+}
+/* The closure of an N-ary operation may return None, in which case the
+   recursion goes on below the tuple: returns 1 if this happens for some
+   tuple, 0 if it never happens, -1 in case of error. */
+static int camlidl_cudd_batch_callN(void* env)
+{
+  CAMLparam0();
+  CAMLlocal4(_v_tbdd,_v_tvdd,_v_tno,_v_res);
+  struct opN* op = (struct opN*)env;
+  struct CuddauxBatch* batch = op->commonN.batch;
+  const int arity = op->commonN.arity;
+  const int arityB = op->arityNbdd;
+  DdNode** tab;
+  node__t no;
+  size_t i;
+  int res = 0;
+
+  if (batch->size==0) CAMLreturnT(int,0);
+  _v_tbdd = caml_alloc(batch->size,0);
+  _v_tvdd = caml_alloc(batch->size,0);
+  for (i=0; i<batch->size; i++){
+    tab = batch->pending+i*arity;
+    _v_tno = camlidl_cudd_tnode_c2ml(op->commonN.man,tab,arityB);
+    Store_field(_v_tbdd,i,_v_tno);
+    _v_tno = camlidl_cudd_tnode_c2ml(op->commonN.man,tab+arityB,arity-arityB);
+    Store_field(_v_tvdd,i,_v_tno);
+  }
+  cuddauxProfileCallback(&op->commonN,(long)batch->size);
+  _v_res = caml_callback3_exn(*caml_named_value("camlidl_cudd_batchN"),
+			      op->closureN,_v_tbdd,_v_tvdd);
+  if (Is_exception_result(_v_res)){
+    op->commonN.exn = Extract_exception(_v_res);
+    CAMLreturnT(int,-1);
+  }
+  for (i=0; i<batch->size; i++){
+    tab = batch->pending+i*arity;
+    _v_tno = Field(_v_res,i);
+    if (Is_block(_v_tno)){
+      camlidl_cudd_node_ml2c(Field(_v_tno,0),&no);
+      if (op->commonN.man != no.man){
+	op->commonN.exn = camlidl_cudd_invalid_exception("Custom.apply_opN: the closure function returned a diagram on a different manager !");
+	CAMLreturnT(int,-1);
+      }
+      if (!cuddauxBatchInsert(batch,tab,no.node))
+	CAMLreturnT(int,-1);
+    }
+    else {
+      if (!cuddauxBatchRecurInsert(batch,tab))
+	CAMLreturnT(int,-1);
+      res = 1;
+    }
+  }
+  batch->size = 0;
+  CAMLreturnT(int,res);
+}
+
+DdNode* camlidl_cudd_custom_op1_batch(DdManager* dd, struct op1* op, DdNode* f)
+{
+  DdNode* res = NULL;
+
+  if (cuddIsConstant(f)){
+    res = cuddauxBatchLookup(op->common1.batch,&f);
+    if (res==NULL)
+      res = camlidl_cudd_custom_op1(dd,op,f);
+  }
+  return res;
+}
+DdNode* camlidl_cudd_custom_op2_batch(DdManager* dd, struct op2* op, DdNode* F, DdNode* G)
+{
+  DdNode* tab[2];
+  DdNode* res = NULL;
+
+  if (cuddIsConstant(F) || cuddIsConstant(G)){
+    tab[0] = F; tab[1] = G;
+    res = cuddauxBatchLookup(op->common2.batch,tab);
+    if (res==NULL && !cuddauxBatchRecurLookup(op->common2.batch,tab))
+      res = camlidl_cudd_custom_op2(dd,op,F,G);
+  }
+  return res;
+}
+DdNode* camlidl_cudd_custom_op3_batch(DdManager* dd, struct op3* op, DdNode* F, DdNode* G, DdNode* H)
+{
+  DdNode* tab[3];
+  DdNode* res = NULL;
+
+  if (cuddIsConstant(F) || cuddIsConstant(G) || cuddIsConstant(H)){
+    tab[0] = F; tab[1] = G; tab[2] = H;
+    res = cuddauxBatchLookup(op->common3.batch,tab);
+    if (res==NULL && !cuddauxBatchRecurLookup(op->common3.batch,tab))
+      res = camlidl_cudd_custom_op3(dd,op,F,G,H);
+  }
+  return res;
+}
+DdNode* camlidl_cudd_custom_opN_batch(DdManager* dd, struct opN* op, DdNode** tnode)
+{
+  DdNode* res;
+  int i;
+
+  for (i=0; i<op->commonN.arity; i++){
+    if (Cudd_IsConstant(tnode[i])) break;
+  }
+  if (i==op->commonN.arity) return NULL;
+  res = cuddauxBatchLookup(op->commonN.batch,tnode);
+  if (res==NULL && !cuddauxBatchRecurLookup(op->commonN.batch,tnode))
+    res = camlidl_cudd_custom_opNG(dd,op,tnode);
+  return res;
+}
+
+static DdNode* camlidl_cudd_batch_apply1(void* env, DdNode** tab)
+{
+  struct op1* op = (struct op1*)env;
+  op->funptr1 = &camlidl_cudd_custom_op1_batch;
+  return Cuddaux_addApply1(op,tab[0]);
+}
+static DdNode* camlidl_cudd_batch_apply2(void* env, DdNode** tab)
+{
+  struct op2* op = (struct op2*)env;
+  op->funptr2 = &camlidl_cudd_custom_op2_batch;
+  return Cuddaux_addApply2(op,tab[0],tab[1]);
+}
+static DdNode* camlidl_cudd_batch_apply3(void* env, DdNode** tab)
+{
+  struct op3* op = (struct op3*)env;
+  op->funptr3 = &camlidl_cudd_custom_op3_batch;
+  return Cuddaux_addApply3(op,tab[0],tab[1],tab[2]);
+}
+static DdNode* camlidl_cudd_batch_applyN(void* env, DdNode** tab)
+{
+  struct opN* op = (struct opN*)env;
+  op->funptrN = &camlidl_cudd_custom_opN_batch;
+  return Cuddaux_addApplyN(op,tab);
+}
+
+/* Common driver. Dynamic reordering is disabled meanwhile, as the batch
+   table is keyed by (possibly internal) nodes. */
+static DdNode* camlidl_cudd_batch_apply(struct common* common,
+					int arityBdd, DdNode** tab,
+					bool commutative,
+					int (*visit)(DdManager*, void*, DdNode**),
+					int (*call)(void*),
+					DdNode* (*apply)(void*, DdNode**),
+					void* op)
+{
+  DdManager* dd = common->man->man;
+  Cudd_ReorderingType heuristic;
+  DdNode* res = NULL;
+  int autodyn, ok;
+
+  autodyn = Cudd_ReorderingStatus(dd,&heuristic);
+  if (autodyn) Cudd_AutodynDisable(dd);
+  common->batch = cuddauxBatchInit(dd,common->arity);
+  if (common->batch!=NULL){
+    do {
+      ok = Cuddaux_addApplyCollect(common,arityBdd,tab,commutative,visit,op) ?
+	call(op) :
+	(-1);
+    } while (ok>0);
+    if (ok==0){
+      res = apply(op,tab);
+      if (res!=NULL) cuddRef(res);
+    }
+    cuddauxBatchQuit(common->batch);
+    common->batch = NULL;
+    if (res!=NULL) cuddDeref(res);
+  }
+  if (autodyn) Cudd_AutodynEnable(dd,CUDD_REORDER_SAME);
+  return res;
+}
+
+DdNode* camlidl_cudd_batch_apply_op1(struct op1* op, DdNode* f)
+{
+  return camlidl_cudd_batch_apply(&op->common1,0,&f,false,
+				  &camlidl_cudd_batch_visit_op1,
+				  &camlidl_cudd_batch_call1,
+				  &camlidl_cudd_batch_apply1,op);
+}
+DdNode* camlidl_cudd_batch_apply_op2(struct op2* op, DdNode* f, DdNode* g)
+{
+  DdNode* tab[2];
+  tab[0] = f; tab[1] = g;
+  return camlidl_cudd_batch_apply(&op->common2,0,tab,op->commutative,
+				  &camlidl_cudd_batch_visit_op2,
+				  &camlidl_cudd_batch_call2,
+				  &camlidl_cudd_batch_apply2,op);
+}
+DdNode* camlidl_cudd_batch_apply_op3(struct op3* op, DdNode* f, DdNode* g, DdNode* h)
+{
+  DdNode* tab[3];
+  tab[0] = f; tab[1] = g; tab[2] = h;
+  return camlidl_cudd_batch_apply(&op->common3,0,tab,false,
+				  &camlidl_cudd_batch_visit_op3,
+				  &camlidl_cudd_batch_call3,
+				  &camlidl_cudd_batch_apply3,op);
+}
+DdNode* camlidl_cudd_batch_apply_opN(struct opN* op, DdNode** tab)
+{
+  return camlidl_cudd_batch_apply(&op->commonN,op->arityNbdd,tab,false,
+				  &camlidl_cudd_batch_visit_opN,
+				  &camlidl_cudd_batch_callN,
+				  &camlidl_cudd_batch_applyN,op);
+}
+
+/* %======================================================================== */
+/* \section{Native kernels} */
+/* %======================================================================== */
+
+/* Kernel operations are OCaml records [{ kcommon: Custom.common; kernel:
+   'a }], where ['a] is one of the variant types [Add.kernel1],
+   [Add.kernel2] or [Add.cmp]. The kernel is decoded once, so that the
+   recursion does not involve the OCaml runtime at all. */
+
+static void camlidl_cudd_kcommon_ml2c(value _v_common, struct common* common)
+{
+  camlidl_cudd_pid_ml2c(Field(_v_common,0), &common->pid);
+  common->arity = Int_val(Field(_v_common,1));
+  camlidl_cudd_memo_ml2c(Field(_v_common,2), &common->memo);
+  common->man = NULL;
+  common->exn = Val_unit;
+  common->batch = NULL;
+}
+
+static void camlidl_cudd_kparam_ml2c(value _v_kernel, double* param)
+{
+  mlsize_t i;
+  for (i=0; i<Wosize_val(_v_kernel); i++){
+    param[i] = Double_val(Field(_v_kernel,i));
+  }
+}
+
+value camlidl_cudd_add_apply_kernel1(value _v_op, value _v_no)
+{
+  CAMLparam2(_v_op,_v_no); CAMLlocal2(_v_kernel,_vres);
+  static const enum cuddaux_kernel kinds[] = {
+    CUDDAUX_KERNEL_AFFINE, CUDDAUX_KERNEL_CLAMP, CUDDAUX_KERNEL_POW,
+    CUDDAUX_KERNEL_MIN_CST, CUDDAUX_KERNEL_MAX_CST
+  };
+  struct kernel1 op;
+  node__t no,_res;
+
+  camlidl_cudd_node_ml2c(_v_no,&no);
+  camlidl_cudd_kcommon_ml2c(Field(_v_op,0),&op.op1.common1);
+  op.op1.common1.man = no.man;
+  _v_kernel = Field(_v_op,1);
+  if (Is_long(_v_kernel)){
+    op.kind = CUDDAUX_KERNEL_ABS;
+  } else {
+    op.kind = kinds[Tag_val(_v_kernel)];
+    camlidl_cudd_kparam_ml2c(_v_kernel,op.param);
+  }
+  _res.man = no.man;
+  _res.node = Cuddaux_addKernel1(&op,no.node);
+  _vres = camlidl_cudd_node_c2ml(&_res);
+  CAMLreturn(_vres);
+}
+
+value camlidl_cudd_add_apply_kernel2(value _v_op, value _v_no1, value _v_no2)
+{
+  CAMLparam3(_v_op,_v_no1,_v_no2); CAMLlocal2(_v_kernel,_vres);
+  static const enum cuddaux_kernel kinds[] = {
+    CUDDAUX_KERNEL_SAT_ADD, CUDDAUX_KERNEL_AFFINE2
+  };
+  struct kernel2 op;
+  node__t no1,no2,_res;
+
+  camlidl_cudd_node_ml2c(_v_no1,&no1);
+  camlidl_cudd_node_ml2c(_v_no2,&no2);
+  if (no1.man!=no2.man){
+    caml_invalid_argument("Add.apply_kernel2: nodes belonging to different managers !");
+  }
+  camlidl_cudd_kcommon_ml2c(Field(_v_op,0),&op.op2.common2);
+  op.op2.common2.man = no1.man;
+  _v_kernel = Field(_v_op,1);
+  if (Is_long(_v_kernel)){
+    op.kind = CUDDAUX_KERNEL_POWER;
+  } else {
+    op.kind = kinds[Tag_val(_v_kernel)];
+    camlidl_cudd_kparam_ml2c(_v_kernel,op.param);
+  }
+  _res.man = no1.man;
+  _res.node = Cuddaux_addKernel2(&op,no1.node,no2.node);
+  _vres = camlidl_cudd_node_c2ml(&_res);
+  CAMLreturn(_vres);
+}
+
+value camlidl_cudd_add_apply_cmp(value _v_op, value _v_no1, value _v_no2)
+{
+  CAMLparam3(_v_op,_v_no1,_v_no2); CAMLlocal1(_vres);
+  struct kernel2 op;
+  node__t no1,no2,_res;
+
+  camlidl_cudd_node_ml2c(_v_no1,&no1);
+  camlidl_cudd_node_ml2c(_v_no2,&no2);
+  if (no1.man!=no2.man){
+    caml_invalid_argument("Add.apply_cmp: nodes belonging to different managers !");
+  }
+  camlidl_cudd_kcommon_ml2c(Field(_v_op,0),&op.op2.common2);
+  op.op2.common2.man = no1.man;
+  op.kind = CUDDAUX_KERNEL_LT + Int_val(Field(_v_op,1));
+  _res.man = no1.man;
+  _res.node = Cuddaux_addBddCompare(&op,no1.node,no2.node);
+  _vres = camlidl_cudd_bdd_c2ml(&_res);
+  CAMLreturn(_vres);
+}
+
+/* Expression operations are OCaml records [{ ecommon: Custom.common;
+   earityBdd: int; ecode: int array; ecsts: float array; estack: int;
+   eregs: int }], see [Add.make_expr] and [Add.make_fused]. */
+
+value camlidl_cudd_add_apply_expr(value _v_op, value _v_vec1, value _v_vec2)
+{
+  CAMLparam3(_v_op,_v_vec1,_v_vec2); CAMLlocal2(_v_code,_vres);
+  struct kernelN op;
+  DdNode** vec;
+  node__t _res;
+  mlsize_t i,size1,size2,size,ncsts;
+  man__t man1,man2,man;
+
+  camlidl_cudd_kcommon_ml2c(Field(_v_op,0),&op.opN.commonN);
+  op.opN.arityNbdd = Int_val(Field(_v_op,1));
+  size1 = Wosize_val(_v_vec1);
+  size2 = Wosize_val(_v_vec2);
+  size = size1+size2;
+  if (size!=op.opN.commonN.arity || size1!=op.opN.arityNbdd){
+    caml_invalid_argument("Add.apply_expr: the arity of the operation is not equal to the size of the arrays of BDDs and ADDs");
+  }
+  else if (size==0){
+    caml_invalid_argument("Add.apply_expr: empty array");
+  }
+  _v_code = Field(_v_op,2);
+  ncsts = Wosize_val(Field(_v_op,3)) / Double_wosize;
+  op.codesize = Wosize_val(_v_code);
+  op.code = (int*)malloc(op.codesize*sizeof(int));
+  op.csts = (double*)malloc((ncsts>0 ? ncsts : 1)*sizeof(double));
+  op.stack = (double*)malloc((Int_val(Field(_v_op,4))>0 ? Int_val(Field(_v_op,4)) : 1)*sizeof(double));
+  op.regs = (double*)malloc((Int_val(Field(_v_op,5))+1)*sizeof(double));
+  vec = (DdNode**)malloc(size*sizeof(DdNode*));
+  if (op.code==NULL || op.csts==NULL || op.stack==NULL || op.regs==NULL || vec==NULL){
+    free(vec); free(op.regs); free(op.stack); free(op.csts); free(op.code);
+    caml_failwith("Add.apply_expr: out of memory");
+  }
+  for (i=0; i<op.codesize; i++){
+    op.code[i] = Int_val(Field(_v_code,i));
+  }
+  for (i=0; i<ncsts; i++){
+    op.csts[i] = Double_field(Field(_v_op,3),i);
+  }
+  man = man1 = man2 = NULL;
+  if (size1>0){
+    man = man1 = camlidl_cudd_tnode_ml2c(_v_vec1,size1,vec);
+  }
+  if (size2>0){
+    man = man2 = camlidl_cudd_tnode_ml2c(_v_vec2,size2,vec+size1);
+  }
+  if ((size1>0 && man1==NULL) || (size2>0 && man2==NULL) ||
+      (size1>0 && size2>0 && man1!=man2)){
+    free(vec); free(op.regs); free(op.stack); free(op.csts); free(op.code);
+    caml_invalid_argument("Add.apply_expr called with BDDs/ADDs belonging to different managers !");
+  }
+  op.opN.commonN.man = man;
+  _res.man = man;
+  _res.node = Cuddaux_addKernelN(&op,vec);
+  free(vec); free(op.regs); free(op.stack); free(op.csts); free(op.code);
+  _vres = camlidl_cudd_node_c2ml(&_res);
+  CAMLreturn(_vres);
+}
@@ -30,9 +30,41 @@ typedef struct node__t add__t;
 typedef struct node__t vdd__t;
 typedef struct node__t mtbdd__t;
 
+/* Pacing of the OCaml GC (Man.set_gc_policy) */
+enum gc_policy {
+  GC_DEFAULT,    /* ratio 1/max given to Man.set_gc */
+  GC_THROUGHPUT, /* ratio derived from the memory used by CUDD */
+  GC_FOOTPRINT   /* same, but 4 times more aggressive */
+};
+
+
+/* The conversion of managers and nodes are done before each CUDD
+   operation: they release the nodes of the dead OCaml values, and
+   restart the limits of the manager */
+void camlidl_cudd_limits_start(struct CuddauxMan* man);
+
+/* Called at the start of each operation on the manager. The limits
+   are not restarted by the operations performed by the OCaml callbacks
+   of an enclosing operation. */
+static inline void camlidl_cudd_man_enter(struct CuddauxMan* man)
+{
+  if (man->npending>0) cuddauxManFlushDerefs(man);
+  if (man->limits.active && man->limits.depth==0)
+    camlidl_cudd_limits_start(man);
+}
+
+/* Bracket the operations which call back OCaml (module Custom, used by
+   modules User and Mapleaf) */
+static inline void camlidl_cudd_man_nest(struct CuddauxMan* man)
+{ man->limits.depth++; }
+static inline void camlidl_cudd_man_unnest(struct CuddauxMan* man)
+{ man->limits.depth--; }
 
 static inline void camlidl_cudd_man_ml2c(value val, struct CuddauxMan** man)
-{ *man = *((struct CuddauxMan**)(Data_custom_val(val))); }
+{
+  *man = *((struct CuddauxMan**)(Data_custom_val(val)));
+  camlidl_cudd_man_enter(*man);
+}
 static inline void camlidl_cudd_hash_ml2c(value val, struct CuddauxHash** hash)
 { *hash = *((struct CuddauxHash**)(Data_custom_val(val))); }
 static inline void camlidl_cudd_cache_ml2c(value val, struct CuddauxCache** cache)
@@ -40,7 +72,10 @@ static inline void camlidl_cudd_cache_ml2c(value val, struct CuddauxCache** cach
 static inline void camlidl_cudd_pid_ml2c(value val, pid* ppid)
 { *ppid = *((void**)(Data_custom_val(val))); }
 static inline void camlidl_cudd_node_ml2c(value val, struct node__t* node)
-{*node = *(node__t*)(Data_custom_val(val)); }
+{
+  *node = *(node__t*)(Data_custom_val(val));
+  camlidl_cudd_man_enter(node->man);
+}
 
 value camlidl_cudd_man_c2ml(struct CuddauxMan** man);
 value camlidl_cudd_hash_c2ml(struct CuddauxHash** hash);
@@ -62,8 +97,20 @@ static inline value camlidl_cudd_mlvalue_c2ml(value* p)
 #define DdNode_of_vnode(x) ((node__t*)(Data_custom_val(x)))->node
 
 value camlidl_cudd_set_gc(value _v_heap, value _v_gc, value _v_reordering);
+void camlidl_cudd_man_init(struct CuddauxMan* man);
+value camlidl_cudd_man_set_hooks(value _v_man, value _v_gc, value _v_reordering);
+value camlidl_cudd_man_set_gc_staged(value _v_man, value _v_othreshold);
+value camlidl_cudd_man_get_gc_stats(value _v_man);
+value camlidl_cudd_man_flush_derefs(value _v_man);
+value camlidl_cudd_man_get_pending_derefs(value _v_man);
+value camlidl_cudd_man_set_limits(value _v_man, value _v_time, value _v_nodes, value _v_steps);
+value camlidl_cudd_man_push_limits(value _v_man, value _v_time, value _v_nodes, value _v_steps);
+value camlidl_cudd_man_pop_limits(value _v_man, value _v_saved);
 int camlidl_cudd_garbage(DdManager* dd, const char* s, void* data);
 int camlidl_cudd_reordering(DdManager* dd, const char* s, void* data);
+int camlidl_cudd_postreordering(DdManager* dd, const char* s, void* data);
+int camlidl_cudd_postgarbage(DdManager* dd, const char* s, void* data);
+value camlidl_cudd_man_set_event_hook(value _v_man, value _v_ofun);
 value camlidl_cudd_custom_copy_shr(value arg);
 
 value camlidl_cudd_bdd_inspect(value vno);
@@ -89,17 +136,44 @@ value camlidl_cudd_add_vectorcompose(value _v_vec, value _v_no);
 value camlidl_cudd_abdd_vectorcompose_memo(bool bdd, value _v_memo,value _v_vec, value _v_no);
 value camlidl_cudd_bdd_vectorcompose_memo(value _v_memo,value _v_vec, value _v_no);
 value camlidl_cudd_add_vectorcompose_memo(value _v_memo,value _v_vec, value _v_no);
+value camlidl_cudd_abdd_apply_array(enum cuddaux_nary op, const char* name,
+				    value _v_simplify, value _v_vec);
+value camlidl_cudd_bdd_dand_array(value _v_simplify, value _v_vec);
+value camlidl_cudd_bdd_dor_array(value _v_simplify, value _v_vec);
+value camlidl_cudd_add_add_array(value _v_vec);
+value camlidl_cudd_add_mul_array(value _v_vec);
+value camlidl_cudd_bdd_relprod_rename_vector(value _v_tsupp, value _v_trel, value _v_no);
 value camlidl_cudd_abdd_permute(bool bdd, value _v_no, value _v_permut);
 value camlidl_cudd_bdd_permute(value _v_no, value _v_permut);
 value camlidl_cudd_add_permute(value _v_no, value _v_permut);
 value camlidl_cudd_abdd_permute_memo(bool bdd, value _v_memo, value _v_no, value _v_permut);
 value camlidl_cudd_bdd_permute_memo(value _v_memo, value _v_no, value _v_permut);
 value camlidl_cudd_add_permute_memo(value _v_memo, value _v_no, value _v_permut);
+value camlidl_cudd_bdd_vectorcompose_array(value _v_memo, value _v_vec, value _v_tno);
+value camlidl_cudd_add_vectorcompose_array(value _v_memo, value _v_vec, value _v_tno);
+value camlidl_cudd_bdd_permute_array(value _v_memo, value _v_tno, value _v_permut);
+value camlidl_cudd_add_permute_array(value _v_memo, value _v_tno, value _v_permut);
+value camlidl_cudd_bdd_vectorcompose_sparse(value _v_subst, value _v_no);
+value camlidl_cudd_add_vectorcompose_sparse(value _v_subst, value _v_no);
+value camlidl_cudd_bdd_permute_sparse(value _v_no, value _v_permut);
+value camlidl_cudd_add_permute_sparse(value _v_no, value _v_permut);
 
 value camlidl_cudd_iter_node(value _v_closure, value _v_no);
 value camlidl_cudd_bdd_iter_cube(value _v_closure, value _v_no);
 value camlidl_cudd_avdd_iter_cube(value _v_closure, value _v_no);
 value camlidl_cudd_bdd_iter_prime(value _v_closure, value _v_lower, value _v_upper);
+value camlidl_cudd_bdd_iter_cube_str(value _v_closure, value _v_buf, value _v_no);
+value camlidl_cudd_bdd_iter_cube_sparse(value _v_closure, value _v_buf, value _v_no);
+value camlidl_cudd_avdd_iter_cube_str(value _v_closure, value _v_buf, value _v_no);
+value camlidl_cudd_avdd_iter_cube_sparse(value _v_closure, value _v_buf, value _v_no);
+value camlidl_cudd_abdd_iter_cube_buf(bool bdd, bool sparse, value _v_closure, value _v_buf, value _v_no);
+value camlidl_cudd_bdd_iter_prime_str(value _v_closure, value _v_buf, value _v_lower, value _v_upper);
+value camlidl_cudd_bdd_iter_prime_sparse(value _v_closure, value _v_buf, value _v_lower, value _v_upper);
+value camlidl_cudd_bdd_iter_prime_buf(bool sparse, value _v_closure, value _v_buf, value _v_lower, value _v_upper);
+value camlidl_cudd_bdd_write_cubes(value _v_sparse, value _v_fd, value _v_no);
+value camlidl_cudd_add_write_cubes(value _v_sparse, value _v_fd, value _v_no);
+value camlidl_cudd_vdd_write_cubes(value _v_sparse, value _v_fd, value _v_no);
+value camlidl_cudd_abdd_write_cubes(int kind, value _v_sparse, value _v_fd, value _v_no);
 value camlidl_cudd_cube_of_bdd(value _v_no);
 value camlidl_cudd_cube_of_minterm(value _v_man, value _v_array);
 value camlidl_cudd_list_of_cube(value _v_no);
@@ -110,8 +184,31 @@ value camlidl_cudd_pick_cubes_on_support(value _v_no1, value _v_no2, value _v_k)
 value camlidl_cudd_avdd_guard_of_leaf(value _v_no, value _v_leaf);
 value camlidl_cudd_avdd_nodes_below_level(value _v_no, value _v_olevel, value _v_omax);
 value camlidl_cudd_avdd_leaves(value _v_no);
+value camlidl_cudd_avdd_guardleafs(value _v_no);
 value camlidl_cudd_avdd_pick_leaf(value _v_no);
 value camlidl_cudd_print(value _v_no);
+value camlidl_cudd_abdd_store(bool bdd, value _v_binary, value _v_filename, value _v_vec);
+value camlidl_cudd_bdd_store(value _v_binary, value _v_filename, value _v_vec);
+value camlidl_cudd_add_store(value _v_filename, value _v_vec);
+value camlidl_cudd_abdd_load(bool bdd, value _v_man, value _v_filename);
+value camlidl_cudd_bdd_load(value _v_man, value _v_filename);
+value camlidl_cudd_add_load(value _v_man, value _v_filename);
+value camlidl_cudd_abdd_write_snapshot(bool bdd, value _v_filename, value _v_vec);
+value camlidl_cudd_bdd_write_snapshot(value _v_filename, value _v_vec);
+value camlidl_cudd_add_write_snapshot(value _v_filename, value _v_vec);
+value camlidl_cudd_snapshot_open(value _v_filename);
+value camlidl_cudd_snapshot_nroots(value _v_snap);
+value camlidl_cudd_abdd_snapshot_eval(bool bdd, value _v_snap, value _v_i, value _v_inputs);
+value camlidl_cudd_bdd_snapshot_eval(value _v_snap, value _v_i, value _v_inputs);
+value camlidl_cudd_add_snapshot_eval(value _v_snap, value _v_i, value _v_inputs);
+value camlidl_cudd_abdd_snapshot_iter_cube(bool bdd, value _v_closure, value _v_snap, value _v_i);
+value camlidl_cudd_bdd_snapshot_iter_cube(value _v_closure, value _v_snap, value _v_i);
+value camlidl_cudd_add_snapshot_iter_cube(value _v_closure, value _v_snap, value _v_i);
+value camlidl_cudd_abdd_of_snapshot(bool bdd, value _v_man, value _v_snap, value _v_i);
+value camlidl_cudd_bdd_of_snapshot(value _v_man, value _v_snap, value _v_i);
+value camlidl_cudd_add_of_snapshot(value _v_man, value _v_snap, value _v_i);
+value camlidl_cudd_vdd_export(value _v_vec);
+value camlidl_cudd_vdd_import(value _v_man, value _v_leaves, value _v_str, value _v_roots);
 
 DdNode* camlidl_cudd_custom_op1(DdManager* dd, struct op1* op, DdNode* node);
 DdNode* camlidl_cudd_custom_op2(DdManager* dd, struct op2* op, DdNode* node1, DdNode* node2);
@@ -121,4 +218,18 @@ int camlidl_cudd_custom_opGbeforeRec(DdManager* dd, struct opG* op, DdNode* no,
 DdNode* camlidl_cudd_custom_opGite(DdManager* dd, struct opG* op, int index, DdNode* T, DdNode* E);
 DdNode* camlidl_cudd_custom_test2(DdManager* dd, struct test2* op, DdNode* node1, DdNode* node2);
 
+DdNode* camlidl_cudd_custom_op1_batch(DdManager* dd, struct op1* op, DdNode* node);
+DdNode* camlidl_cudd_custom_op2_batch(DdManager* dd, struct op2* op, DdNode* node1, DdNode* node2);
+DdNode* camlidl_cudd_custom_op3_batch(DdManager* dd, struct op3* op, DdNode* node1, DdNode* node2, DdNode* node3);
+DdNode* camlidl_cudd_custom_opN_batch(DdManager* dd, struct opN* op, DdNode** node);
+DdNode* camlidl_cudd_batch_apply_op1(struct op1* op, DdNode* f);
+DdNode* camlidl_cudd_batch_apply_op2(struct op2* op, DdNode* f, DdNode* g);
+DdNode* camlidl_cudd_batch_apply_op3(struct op3* op, DdNode* f, DdNode* g, DdNode* h);
+DdNode* camlidl_cudd_batch_apply_opN(struct opN* op, DdNode** tab);
+
+value camlidl_cudd_add_apply_kernel1(value _v_op, value _v_no);
+value camlidl_cudd_add_apply_kernel2(value _v_op, value _v_no1, value _v_no2);
+value camlidl_cudd_add_apply_cmp(value _v_op, value _v_no1, value _v_no2);
+value camlidl_cudd_add_apply_expr(value _v_op, value _v_vec1, value _v_vec2);
+
 #endif
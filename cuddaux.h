@@ -29,10 +29,104 @@ typedef struct CuddauxDdNode {
   CuddauxType type;
 } CuddauxDdNode;
 
+/* Statistics on a stage of the OCaml collections triggered by CUDD
+   garbage collections */
+struct CuddauxGcStage {
+  long count;   /* number of times the stage has been run */
+  long time;    /* cumulated time, in milliseconds */
+  double freed; /* cumulated number of CUDD nodes made dead */
+};
+
+/* A set of limits and the counters checked against them */
+struct CuddauxLimit {
+  double time;  /* wall time in seconds, 0.0: no limit */
+  double nodes; /* nodes allocated, 0.0: no limit */
+  double steps; /* recursion steps, 0.0: no limit */
+  double start_time;
+  double start_nodes;
+  double nsteps;
+};
+
+/* Limits on the operations of a manager, checked by the termination
+   callback of CUDD */
+struct CuddauxLimits {
+  bool active;  /* the termination callback is installed */
+  bool expired; /* a limit has been exceeded */
+  struct CuddauxLimit op;    /* limits of Man.set_limits, counted from
+				the start of each operation */
+  struct CuddauxLimit scope; /* limits of the innermost Man.with_limits,
+				intersected with those of the enclosing
+				ones, counted from its call */
+  int depth;    /* operations in progress which call back OCaml */
+};
+
+/* Reordering or garbage collection being reported to the event hook of
+   a manager, recorded by the pre hook and completed by the post hook */
+struct CuddauxEvent {
+  int heuristic;   /* Cudd_ReorderingType */
+  long nodes;      /* nodes in the unique tables before */
+  long dead;       /* dead nodes before */
+  long start_time; /* in milliseconds */
+};
+
+/* Profiling counters of an operation. The pid of an operation points to
+   them; they are updated only when the profiling of the manager is on. */
+struct CuddauxProfile {
+  long calls;     /* top-level calls */
+  long steps;     /* recursive steps */
+  long hits[3];   /* memoization hits and misses, */
+  long misses[3]; /* indexed by enum memo_discr */
+  long callbacks; /* calls to OCaml closures */
+  long nodes;     /* nodes allocated during the calls */
+};
+
+/* Tags of the built-in operations using a struct common */
+enum cuddaux_builtin {
+  CUDDAUX_BDD_VECTORCOMPOSE_MEMO,
+  CUDDAUX_ADD_VECTORCOMPOSE_MEMO,
+  CUDDAUX_BDD_PERMUTE_MEMO,
+  CUDDAUX_ADD_PERMUTE_MEMO,
+  CUDDAUX_ADD_VECTORCOMPOSE,
+  CUDDAUX_BUILTIN_NB
+};
+extern const char* cuddauxBuiltinName[CUDDAUX_BUILTIN_NB];
+
+/* All the mutable state of the binding attached to a manager lives here,
+   and the DdManager points back to it with its field hooks, so that
+   managers used by different threads do not share anything. */
 struct CuddauxMan {
   DdManager* man;
   size_t count;
   bool caml; /* true: support Caml values in ADD leaves, false: does not */
+  value gc_fun;          /* hook called before a CUDD garbage collection,
+			    or Val_unit for the default one */
+  value reordering_fun;  /* hook called before a CUDD reordering,
+			    or Val_unit for the default one */
+  intnat old_compactions; /* number of OCaml heap compactions at the last
+			     lookup of a constant with an OCaml leaf */
+  DdNode** pending;      /* nodes released by OCaml finalizers and not yet
+			    dereferenced; each one holds a reference to
+			    the manager */
+  size_t npending;
+  size_t maxpending;
+  int gc_policy;         /* pacing of the OCaml GC w.r.t. the memory held
+			    by the diagrams of the manager
+			    (enum gc_policy in cudd_caml.h) */
+  double gc_staged;      /* if positive, Gc.minor and a bounded
+			    Gc.major_slice are performed first, and
+			    gc_fun is called only if the ratio dead/keys
+			    stays below it */
+  struct CuddauxGcStage gc_stage[2];
+  struct CuddauxHash* hashes; /* hash tables bound to the manager */
+  struct CuddauxLimits limits;
+  bool profiling;        /* update the profiling counters of operations */
+  struct CuddauxProfile builtin[CUDDAUX_BUILTIN_NB]; /* counters of the
+						       built-in operations */
+  long id;               /* identifier reported in events */
+  value event_fun;       /* hook called after a reordering or a garbage
+			    collection, or Val_unit */
+  bool requested;        /* inside Man.reduce_heap or Man.garbage_collect */
+  struct CuddauxEvent event[2]; /* reordering, garbage collection */
 };
 
 struct CuddauxHash {
@@ -40,6 +134,10 @@ struct CuddauxHash {
   size_t arity;
   size_t initialsize;
   struct CuddauxMan* man;
+  struct CuddauxHash* prev; /* doubly linked list of the hash tables */
+  struct CuddauxHash* next; /* bound to man */
+  DdNode** pins; /* keys referenced during a reordering, or NULL */
+  size_t npins;
 };
 
 struct node__t {
@@ -56,7 +154,7 @@ struct CuddauxCache {
 };
 typedef struct CuddauxCache* CuddauxCache;
 
-typedef void* pid;
+typedef void* pid; /* points to a struct CuddauxProfile */
 enum memo_discr { Global, Cache, Hash };
 union memo_union {
   struct CuddauxCache* cache;
@@ -66,16 +164,27 @@ struct memo__t {
   enum memo_discr discr;
   union memo_union u;
 };
+/* Tuples of nodes collected by a batched operation, with their results */
+struct CuddauxBatch {
+  DdHashTable* table; /* tuples -> results */
+  DdHashTable* recur; /* tuples below which the recursion goes on */
+  int arity;
+  size_t size;        /* number of pending tuples */
+  size_t maxsize;
+  DdNode** pending;   /* pending tuples, stored contiguously */
+};
 struct common {
   pid pid;
   int arity;
   struct memo__t memo;
   struct CuddauxMan* man;
   value exn;
+  struct CuddauxBatch* batch;
 };
 struct op1 {
   struct common common1;
   value closure1;
+  bool batch1;
   DdNode* (*funptr1)(DdManager*, struct op1*,DdNode*);
 };
 struct op2 {
@@ -84,6 +193,7 @@ struct op2 {
   value ospecial2;
   bool commutative;
   bool idempotent;
+  bool batch2;
   DdNode* (*funptr2)(DdManager*, struct op2*,DdNode*,DdNode*);
 };
 struct test2 {
@@ -98,12 +208,14 @@ struct op3 {
   struct common common3;
   value closure3;
   value ospecial3;
+  bool batch3;
   DdNode* (*funptr3)(DdManager*, struct op3*,DdNode*,DdNode*,DdNode*);
 };
 struct opN {
   struct common commonN;
   int arityNbdd;
   value closureN;
+  bool batchN;
   DdNode* (*funptrN)(DdManager*, struct opN*, DdNode**);
 };
 struct opG {
@@ -137,21 +249,131 @@ struct existandop1 {
   value bottomexistandop1;
 };
 
-struct cuddaux_list_t {
-  struct cuddaux_list_t* next;
-  DdNode* node;
+/* Entry of a sparse substitution, see Cuddaux_SparseComposeArrayCommon */
+struct CuddauxSubst {
+  int index;     /* substituted variable */
+  DdNode* func;  /* BDD substituted to it */
+  int level;     /* level of index, set by Cuddaux_SparseComposeArrayCommon */
+};
+
+/* Predefined leaf operations on ADDs with double leaves */
+enum cuddaux_kernel {
+  /* unary */
+  CUDDAUX_KERNEL_AFFINE,  /* x -> param[0]*x + param[1] */
+  CUDDAUX_KERNEL_CLAMP,   /* x -> min param[1] (max param[0] x) */
+  CUDDAUX_KERNEL_ABS,
+  CUDDAUX_KERNEL_POW,     /* x -> x**param[0] */
+  CUDDAUX_KERNEL_MIN_CST, /* x -> min x param[0] */
+  CUDDAUX_KERNEL_MAX_CST, /* x -> max x param[0] */
+  /* binary */
+  CUDDAUX_KERNEL_SAT_ADD, /* x,y -> min param[1] (max param[0] (x+y)) */
+  CUDDAUX_KERNEL_AFFINE2, /* x,y -> param[0]*x + param[1]*y + param[2] */
+  CUDDAUX_KERNEL_POWER,   /* x,y -> x**y */
+  /* binary, with a BDD as result */
+  CUDDAUX_KERNEL_LT,
+  CUDDAUX_KERNEL_LE,
+  CUDDAUX_KERNEL_EQ,
+  CUDDAUX_KERNEL_NE,
+  CUDDAUX_KERNEL_GE,
+  CUDDAUX_KERNEL_GT
+};
+/* Associative operations combined by Cuddaux_ApplyArray */
+enum cuddaux_nary {
+  CUDDAUX_BDD_AND,
+  CUDDAUX_BDD_OR,
+  CUDDAUX_ADD_PLUS,
+  CUDDAUX_ADD_TIMES
+};
+struct kernel1 {
+  struct op1 op1; /* only common1 has to be filled */
+  enum cuddaux_kernel kind;
+  double param[3];
+};
+struct kernel2 {
+  struct op2 op2; /* only common2 has to be filled */
+  enum cuddaux_kernel kind;
+  double param[3];
+};
+/* Instructions of compiled leaf expressions, evaluated on a stack of
+   doubles. VAR, BVAR and CST are followed by an operand: the index of an
+   ADD argument, of a BDD argument, or of a constant. Comparisons and NOT
+   push 1.0 or 0.0, SELECT pops c,x,y and pushes (c!=0.0 ? x : y). STORE
+   pops a value into the register given as operand, LOAD pushes it.
+   The CUDD_ binary operations apply to the leaves the terminal cases of
+   Cudd_addPlus, Cudd_addMinus,... (for instance 0*x = 0 even for an
+   infinite or NaN x), as used by Add.make_fused. */
+enum cuddaux_expr {
+  CUDDAUX_EXPR_VAR, CUDDAUX_EXPR_BVAR, CUDDAUX_EXPR_CST,
+  CUDDAUX_EXPR_NEG, CUDDAUX_EXPR_ABS,
+  CUDDAUX_EXPR_ADD, CUDDAUX_EXPR_SUB, CUDDAUX_EXPR_MUL, CUDDAUX_EXPR_DIV,
+  CUDDAUX_EXPR_MIN, CUDDAUX_EXPR_MAX,
+  CUDDAUX_EXPR_LT, CUDDAUX_EXPR_LE, CUDDAUX_EXPR_EQ, CUDDAUX_EXPR_NOT,
+  CUDDAUX_EXPR_SELECT,
+  CUDDAUX_EXPR_LOAD, CUDDAUX_EXPR_STORE,
+  CUDDAUX_EXPR_CUDD_PLUS, CUDDAUX_EXPR_CUDD_MINUS,
+  CUDDAUX_EXPR_CUDD_TIMES, CUDDAUX_EXPR_CUDD_DIVIDE,
+  CUDDAUX_EXPR_CUDD_MINIMUM, CUDDAUX_EXPR_CUDD_MAXIMUM
+};
+struct kernelN {
+  struct opN opN; /* only commonN and arityNbdd have to be filled */
+  int* code;
+  size_t codesize;
+  double* csts;
+  double* stack; /* large enough for the evaluation of code */
+  double* regs;  /* registers used by LOAD and STORE */
+};
+
+/* Read-only snapshots of BDD/ADD forests, see cuddauxSnapshot.c */
+#define CUDDAUX_SNAPSHOT_MAGIC "CUDDSNAP"
+#define CUDDAUX_SNAPSHOT_VERSION 1
+struct CuddauxSnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t add;     /* 0: BDDs, 1: ADDs with double leaves */
+  uint32_t nvars;
+  uint32_t nroots;
+  uint64_t nnodes;
+};
+struct CuddauxSnapshotNode {
+  uint32_t index;   /* CUDD_CONST_INDEX for constant nodes */
+  uint32_t pad;
+  union {
+    struct { uint64_t T,E; } kids; /* edges: (position << 1) | complement */
+    double dbl;
+  } type;
+};
+struct CuddauxSnapshot {
+  void* base;       /* mapped file */
+  size_t size;
+  const struct CuddauxSnapshotHeader* header;
+  const int32_t* invperm;
+  const int32_t* perm;
+  const uint64_t* roots;
+  const struct CuddauxSnapshotNode* nodes;
 };
-typedef struct cuddaux_list_t cuddaux_list_t;
 
 /* ********************************************************************** */
 /* Function Prototypes */
 /* ********************************************************************** */
 
 void cuddauxManFree(struct CuddauxMan* man);
+void cuddauxManDeferDeref(struct CuddauxMan* man, DdNode* node);
+void cuddauxManFlushDerefs(struct CuddauxMan* man);
 DdLocalCache* cuddauxCacheReinit(struct CuddauxMan* man, struct CuddauxCache* cache);
 DdHashTable* cuddauxHashReinit(struct CuddauxMan* man, struct CuddauxHash* hash);
+bool cuddauxHashPrune(struct CuddauxHash* hash);
+bool cuddauxHashPin(struct CuddauxHash* hash, bool pin);
+void cuddauxManPruneHashes(struct CuddauxMan* man);
+bool cuddauxManPinHashes(struct CuddauxMan* man, bool pin);
 DdNode* cuddauxCommonLookupN(struct common* common, DdNode** tab);
 DdNode* cuddauxCommonInsertN(struct common* common, DdNode** tab, DdNode* res);
+struct CuddauxBatch* cuddauxBatchInit(DdManager* dd, int arity);
+void cuddauxBatchQuit(struct CuddauxBatch* batch);
+DdNode* cuddauxBatchLookup(struct CuddauxBatch* batch, DdNode** tab);
+int cuddauxBatchInsert(struct CuddauxBatch* batch, DdNode** tab, DdNode* res);
+int cuddauxBatchRecurLookup(struct CuddauxBatch* batch, DdNode** tab);
+int cuddauxBatchRecurInsert(struct CuddauxBatch* batch, DdNode** tab);
+int cuddauxBatchPush(struct CuddauxBatch* batch, DdNode** tab);
 
 /* f is a BDD, g and h are ADDs */
 DdNode* Cuddaux_addIte(DdManager* dd, DdNode* f, DdNode* g, DdNode* h);
@@ -191,6 +413,21 @@ DdNode* Cuddaux_addVectorCompose(struct CuddauxMan* man, DdNode* f, DdNode** vec
 /* f is a BDD, vector an array of BDDs */
 DdNode* Cuddaux_bddVectorComposeCommon(struct common* common, DdNode* f, DdNode** vector);
 DdNode* Cuddaux_bddPermuteCommon(struct common* common, DdNode* f, int* permut);
+/* tf is an array of BDDs (bdd==true) or ADDs, vector an array of BDDs */
+int Cuddaux_VectorComposeArrayCommon(struct common* common, bool bdd,
+				     DdNode** tf, int size,
+				     DdNode** vector, DdNode** tres);
+int Cuddaux_PermuteArrayCommon(struct common* common, bool bdd,
+			       DdNode** tf, int size,
+			       int* permut, DdNode** tres);
+int Cuddaux_SparseComposeArrayCommon(struct common* common, bool bdd,
+				     DdNode** tf, int size,
+				     struct CuddauxSubst* subst, int nsubst,
+				     DdNode** tres);
+/* f, g and cube are BDDs, tg and tcube arrays of BDDs */
+DdNode* Cuddaux_bddAndAbstractVarMap(DdManager* dd, DdNode* f, DdNode* g, DdNode* cube);
+DdNode* Cuddaux_bddAndAbstractVarMapVector(DdManager* dd, DdNode* f,
+					   DdNode** tg, DdNode** tcube, int size);
 
 /* f, g and h are ADDs */
 DdNode* Cuddaux_addApply1(struct op1* op, DdNode* f);
@@ -199,6 +436,16 @@ int Cuddaux_addTest2(struct test2* op, DdNode* f, DdNode* g);
 DdNode* Cuddaux_addApply3(struct op3* op, DdNode* f, DdNode* g, DdNode* h);
 DdNode* Cuddaux_addApplyN(struct opN* op, DdNode** tab);
 DdNode* Cuddaux_addApplyG(struct opG* op, DdNode** tab);
+int Cuddaux_addApplyCollect(struct common* common, int arityBdd,
+			    DdNode** tab, bool commutative,
+			    int (*visit)(DdManager*, void*, DdNode**), void* env);
+/* f and g are ADDs with double leaves */
+DdNode* Cuddaux_addKernel1(struct kernel1* op, DdNode* f);
+DdNode* Cuddaux_addKernel2(struct kernel2* op, DdNode* f, DdNode* g);
+DdNode* Cuddaux_addBddCompare(struct kernel2* op, DdNode* f, DdNode* g);
+/* the first op->opN.arityNbdd elements of tab are BDDs, the other ones
+   ADDs with double leaves */
+DdNode* Cuddaux_addKernelN(struct kernelN* op, DdNode** tab);
 DdNode* Cuddaux_addAbstract(struct exist* op, DdNode* f, DdNode* cube);
 DdNode* Cuddaux_addApplyAbstract(struct existop1* op, DdNode* f, DdNode* cube);
 DdNode*
@@ -217,10 +464,20 @@ int Cuddaux_ClassifySupport(DdManager* dd, DdNode* f, DdNode* g, DdNode** common
 /* f is a BDD/ADD node and var a projection function */
 bool Cuddaux_IsVarIn(DdManager* dd, DdNode* f, DdNode* var);
 /* f is a BDD/ADD node and level a level. */
-cuddaux_list_t* Cuddaux_NodesBelowLevel(DdManager* dd, DdNode* f, int level, size_t max, size_t* psize, bool take_background);
-void cuddaux_list_free(cuddaux_list_t* l);
+DdNode** Cuddaux_NodesBelowLevel(DdManager* dd, DdNode* f, int level, size_t max, size_t* psize, bool take_background);
+/* roots are BDDs or ADDs with double leaves */
+int Cuddaux_SnapshotWrite(DdManager* dd, bool add, DdNode** roots, int nroots, const char* filename);
+struct CuddauxSnapshot* Cuddaux_SnapshotOpen(const char* filename);
+void Cuddaux_SnapshotClose(struct CuddauxSnapshot* snap);
+uint64_t Cuddaux_SnapshotEval(const struct CuddauxSnapshot* snap, uint64_t edge, const int* inputs, int ninputs);
+DdNode* Cuddaux_SnapshotToDd(DdManager* dd, const struct CuddauxSnapshot* snap, uint64_t edge);
 /* f and h are ADDs */
 DdNode* Cuddaux_addGuardOfNode(DdManager* dd, DdNode* f, DdNode* h);
+int Cuddaux_addGuardLeafs(DdManager* dd, DdNode* f, bool take_background,
+			  DdNode*** pleaves, DdNode*** pguards, size_t* psize);
+/* tab contains BDDs (AND, OR) or ADDs with double leaves (PLUS, TIMES) */
+DdNode* Cuddaux_ApplyArray(DdManager* dd, enum cuddaux_nary op, bool simplify,
+			   DdNode** tab, int size, int* ppeak);
 DdNode* Cuddaux_addCamlConst(DdManager* unique, value value);
 int Cuddaux_addCamlPreGC(DdManager* unique, const char* s, void* data);
 
@@ -258,6 +515,7 @@ DdNode* cuddauxAddTest2Recur(DdManager* dd, struct test2* op, DdNode* f, DdNode*
 DdNode* cuddauxAddApply3Recur(DdManager* dd, struct op3* op, DdNode* f, DdNode* g, DdNode* h);
 DdNode* cuddauxAddApplyNRecur(DdManager * dd, struct opN* op, DdNode ** tab);
 DdNode* cuddauxAddApplyGRecur(DdManager * dd, struct opG* op, DdNode ** tab);
+DdNode* cuddauxAddBddCompareRecur(DdManager* dd, struct kernel2* op, DdNode* f, DdNode* g);
 DdNode* cuddauxAddAbstractRecur(DdManager * dd,
 			struct exist* op,
 			DdNode * f, /* ADD */
@@ -297,6 +555,7 @@ void cuddauxAddCamlConstRehash(DdManager* unique, int offset);
 #define DDAUX_ADD_ITE_TAG            0xee
 #define DDAUX_ADD_ITE_CONSTANT_TAG   0xea
 #define DDAUX_ADD_COMPOSE_RECUR_TAG  0xe6
+#define DDAUX_BDD_AND_ABSTRACT_VARMAP_TAG 0xe2
 
 /* ********************************************************************** */
 /* Inline Functions */
@@ -337,6 +596,10 @@ static inline bool CuddauxTypeEqual(bool caml, CuddauxType* type1, CuddauxType*
 }
 
 #define cuddauxManRef(x) do { if((x)->count<SIZE_MAX) (x)->count++; } while(0)
+static inline struct CuddauxMan* cuddauxManOfDd(DdManager* dd)
+{
+  return (struct CuddauxMan*)dd->hooks;
+}
 static inline struct CuddauxMan* cuddauxManCopy(struct CuddauxMan* man)
 {
   cuddauxManRef(man);
@@ -359,6 +622,11 @@ static inline void cuddauxHashClear(struct CuddauxHash* hash)
 {
   assert( (hash->hash==NULL)==(hash->man==NULL) );
   if (hash->hash){
+    cuddauxHashPin(hash,false);
+    if (hash->prev) hash->prev->next = hash->next;
+    else hash->man->hashes = hash->next;
+    if (hash->next) hash->next->prev = hash->prev;
+    hash->prev = hash->next = NULL;
     cuddHashTableQuit(hash->hash);
     cuddauxManFree(hash->man);
     hash->hash = NULL;
@@ -395,6 +663,35 @@ static inline void* cuddauxCommonReinit(struct common* common)
   }
 }
 
+static inline void cuddauxProfileCall(struct common* common, double allocated)
+{
+  if (common->man->profiling){
+    struct CuddauxProfile* prof = (struct CuddauxProfile*)common->pid;
+    prof->calls++;
+    prof->nodes += (long)(common->man->man->allocated - allocated);
+  }
+}
+static inline void cuddauxProfileStep(struct common* common)
+{
+  if (common->man->profiling)
+    ((struct CuddauxProfile*)common->pid)->steps++;
+}
+static inline void cuddauxProfileCallback(struct common* common, long n)
+{
+  if (common->man->profiling)
+    ((struct CuddauxProfile*)common->pid)->callbacks += n;
+}
+static inline void cuddauxProfileLookup(struct common* common, DdNode* res)
+{
+  if (common->man->profiling){
+    struct CuddauxProfile* prof = (struct CuddauxProfile*)common->pid;
+    if (res!=NULL)
+      prof->hits[common->memo.discr]++;
+    else
+      prof->misses[common->memo.discr]++;
+  }
+}
+
 static inline DdNode* cuddauxCommonLookup1(struct common* common, DdNode* f)
 {
   DdNode* res = NULL;
@@ -412,6 +709,7 @@ static inline DdNode* cuddauxCommonLookup1(struct common* common, DdNode* f)
   default:
     abort();
   }
+  cuddauxProfileLookup(common,res);
   return res;
 }
 static inline DdNode* cuddauxCommonLookup2(struct common* common, DdNode* f, DdNode* g)
@@ -436,6 +734,7 @@ static inline DdNode* cuddauxCommonLookup2(struct common* common, DdNode* f, DdN
   default:
     abort();
   }
+  cuddauxProfileLookup(common,res);
   return res;
 }
 static inline DdNode* cuddauxCommonLookup3(struct common* common, DdNode* f, DdNode* g, DdNode* h)
@@ -461,6 +760,7 @@ static inline DdNode* cuddauxCommonLookup3(struct common* common, DdNode* f, DdN
   default:
     abort();
   }
+  cuddauxProfileLookup(common,res);
   return res;
 }
 
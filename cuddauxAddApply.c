@@ -16,6 +16,7 @@
 		<li> Cuddaux_addApply2()
 		<li> Cuddaux_addTest2()
 		<li> Cuddaux_addApply3()
+		<li> Cuddaux_addApplyCollect()
 		<li> Cuddaux_addAbstract()
 		<li> Cuddaux_addBddAndAbstract()
 		<li> Cuddaux_addApplyBddAndAbstract()
@@ -54,6 +55,7 @@
 /* Static function prototypes                                                */
 /*---------------------------------------------------------------------------*/
 static int bddCheckPositiveCube (DdManager *manager, DdNode *cube);
+static int cuddauxAddApplyCollectRecur(DdManager* dd, struct common* common, DdHashTable* visited, int arityBdd, DdNode** tab, bool commutative, int (*visit)(DdManager*, void*, DdNode**), void* env);
 
 /**AutomaticEnd***************************************************************/
 
@@ -82,11 +84,13 @@ Cuddaux_addApply1(struct op1* op,
 {
   DdNode *res;
   DdManager* dd = op->common1.man->man;
+  double allocated = dd->allocated;
   do {
     dd->reordered = 0;
     if (cuddauxCommonReinit(&op->common1)==NULL) return NULL;
     res = cuddauxAddApply1Recur(dd,op,f);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->common1,allocated);
   return(res);
 
 } /* end of Cuddaux_addApply1 */
@@ -113,12 +117,14 @@ Cuddaux_addApply2(struct op2* op,
 {
   DdNode *res;
   DdManager* dd = op->common2.man->man;
+  double allocated = dd->allocated;
 
   do {
     dd->reordered = 0;
     if (cuddauxCommonReinit(&op->common2)==NULL) return NULL;
     res = cuddauxAddApply2Recur(dd,op,f,g);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->common2,allocated);
   return(res);
 } /* end of Cuddaux_addApply2 */
 
@@ -145,12 +151,14 @@ Cuddaux_addTest2(struct test2* op,
   DdNode *res;
   int ret;
   DdManager* dd = op->common2t.man->man;
+  double allocated = dd->allocated;
 
   do {
     dd->reordered = 0;
     if (cuddauxCommonReinit(&op->common2t)==NULL) return -1;
     res = cuddauxAddTest2Recur(dd,op,f,g);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->common2t,allocated);
   ret = res==NULL ? (-1) : (res==DD_ONE(dd));
   return ret;
 } /* end of Cuddaux_addTest2 */
@@ -179,11 +187,13 @@ Cuddaux_addApply3(struct op3* op,
 {
   DdNode *res;
   DdManager* dd = op->common3.man->man;
+  double allocated = dd->allocated;
   do {
     dd->reordered = 0;
     if (cuddauxCommonReinit(&op->common3)==NULL) return NULL;
     res = cuddauxAddApply3Recur(dd,op,f,g,h);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->common3,allocated);
   return(res);
 } /* end of Cuddaux_addApply3 */
 
@@ -193,11 +203,13 @@ Cuddaux_addApplyN(struct opN* op,
 {
   DdNode *res;
   DdManager* dd = op->commonN.man->man;
+  double allocated = dd->allocated;
   do {
     dd->reordered = 0;
     if (cuddauxCommonReinit(&op->commonN)==NULL) return NULL;
     res = cuddauxAddApplyNRecur(dd,op,tab);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->commonN,allocated);
   return(res);
 } /* end of Cuddaux_addApplyN */
 DdNode*
@@ -206,14 +218,59 @@ Cuddaux_addApplyG(struct opG* op,
 {
   DdNode *res;
   DdManager* dd = op->commonG.man->man;
+  double allocated = dd->allocated;
   do {
     dd->reordered = 0;
     if (cuddauxCommonReinit(&op->commonG)==NULL) return NULL;
     res = cuddauxAddApplyGRecur(dd,op,tab);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->commonG,allocated);
   return(res);
 } /* end of Cuddaux_addApplyG */
 
+/**Function********************************************************************
+
+  Synopsis    [Collects the tuples of nodes on which a batched operation
+  needs its closure.]
+
+  Description [Explores the product of the diagrams in tab as the
+  recursion of Cuddaux_addApplyN does, but without building any node.
+  The first arityBdd elements of tab are BDDs, the other ones ADDs.
+
+  Each tuple is visited once. Tuples found in the memoization table of
+  common are skipped, unless it is a hash table (looking up such a table
+  modifies it). Otherwise visit(dd,env,tuple) is called; it returns 1 if
+  the exploration should go on below the tuple, 0 if it should stop, and
+  -1 in case of error. If commutative is true, the two elements of a pair
+  are ordered as in cuddauxAddApply2Recur.
+
+  Returns 1 if successful, 0 otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_addApplyN cuddauxBatchPush]
+
+******************************************************************************/
+int
+Cuddaux_addApplyCollect(struct common* common,
+			int arityBdd,
+			DdNode** tab,
+			bool commutative,
+			int (*visit)(DdManager*, void*, DdNode**),
+			void* env)
+{
+  DdHashTable* visited;
+  int res;
+  DdManager* dd = common->man->man;
+
+  if (cuddauxCommonReinit(common)==NULL) return 0;
+  visited = cuddHashTableInit(dd,common->arity,256);
+  if (visited==NULL) return 0;
+  res = cuddauxAddApplyCollectRecur(dd,common,visited,arityBdd,tab,commutative,visit,env);
+  cuddHashTableQuit(visited);
+  return res;
+} /* end of Cuddaux_addApplyCollect */
+
 /**Function********************************************************************
 
   Synopsis:
@@ -240,6 +297,7 @@ Cuddaux_addAbstract(struct exist* op,
 {
   DdNode *res;
   DdManager* dd = op->commonexist.man->man;
+  double allocated = dd->allocated;
 
   if (bddCheckPositiveCube(dd, cube) == 0) {
     (void) fprintf(dd->err,
@@ -254,6 +312,7 @@ Cuddaux_addAbstract(struct exist* op,
       return NULL;
     res = cuddauxAddAbstractRecur(dd,op,f,cube);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->commonexist,allocated);
   return(res);
 } /* end of Cuddaux_addAbstract */
 
@@ -284,6 +343,7 @@ Cuddaux_addApplyAbstract(struct existop1* op,
 {
   DdNode *res;
   DdManager* dd = op->commonexistop1.man->man;
+  double allocated = dd->allocated;
 
   if (bddCheckPositiveCube(dd, cube) == 0) {
     (void) fprintf(dd->err,
@@ -299,6 +359,7 @@ Cuddaux_addApplyAbstract(struct existop1* op,
       return NULL;
     res = cuddauxAddApplyAbstractRecur(dd,op,f,cube);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->commonexistop1,allocated);
   return(res);
 } /* end of Cuddaux_addApplyAbstract */
 
@@ -333,6 +394,7 @@ Cuddaux_addBddAndAbstract(struct existand* op,
 {
   DdNode *res;
   DdManager* dd = op->commonexistand.man->man;
+  double allocated = dd->allocated;
 
   if (bddCheckPositiveCube(dd, cube) == 0) {
     (void) fprintf(dd->err,
@@ -347,6 +409,7 @@ Cuddaux_addBddAndAbstract(struct existand* op,
       return NULL;
     res = cuddauxAddBddAndAbstractRecur(dd,op,f,G,cube,background);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->commonexistand,allocated);
   return(res);
 } /* end of Cuddaux_addApplyBddAndAbstract */
 
@@ -373,6 +436,7 @@ Cuddaux_addApplyBddAndAbstract(struct existandop1* op,
 {
   DdNode *res;
   DdManager* dd = op->commonexistandop1.man->man;
+  double allocated = dd->allocated;
 
   if (bddCheckPositiveCube(dd, cube) == 0) {
     (void) fprintf(dd->err,
@@ -388,6 +452,7 @@ Cuddaux_addApplyBddAndAbstract(struct existandop1* op,
       return NULL;
     res = cuddauxAddApplyBddAndAbstractRecur(dd,op,f,G,cube,background);
   } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->commonexistandop1,allocated);
   return(res);
 } /* end of Cuddaux_addApplyBddAndAbstract */
 
@@ -416,6 +481,8 @@ cuddauxAddApply1Recur(DdManager * dd,
   unsigned int index;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->common1);
   assert (f->ref>=1);
 
   /* Check cache. */
@@ -483,6 +550,8 @@ cuddauxAddApply2Recur(DdManager * dd,
   DD_CTFP cacheOp;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->common2);
   assert (f->ref>=1);
   assert (g->ref>=1);
 
@@ -572,6 +641,7 @@ cuddauxAddTest2Recur(DdManager * dd,
    * cache hit rate.
    */
   statLine(dd);
+  cuddauxProfileStep(&op->common2t);
   assert (f->ref>=1);
   assert (g->ref>=1);
 
@@ -649,6 +719,8 @@ cuddauxAddApply3Recur(
     unsigned int index;
 
     statLine(dd);
+    if (cuddGiveUp(dd)) return(NULL);
+    cuddauxProfileStep(&op->common3);
     assert (f->ref>=1);
     assert (g->ref>=1);
     assert (h->ref>=1);
@@ -793,6 +865,8 @@ cuddauxAddApplyNRecur(DdManager * dd,
   unsigned int index;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->commonN);
 
   const int size = op->commonN.arity;
   const int sizeBdd = op->arityNbdd;
@@ -851,6 +925,8 @@ cuddauxAddApplyGRecur(DdManager * dd,
   unsigned int index;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->commonG);
   const int size = op->commonG.arity;
   const int sizeBdd = op->arityGbdd;
   assert(sizeBdd<=size);
@@ -954,6 +1030,8 @@ cuddauxAddAbstractRecur(DdManager * dd,
   unsigned int topf, topcube, top, index;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->commonexist);
   one = DD_ONE(dd);
   zero = Cudd_Not(one);
 
@@ -1054,6 +1132,8 @@ cuddauxAddApplyAbstractRecur(DdManager * dd,
   unsigned int topf, topcube, top, index;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->commonexistop1);
   one = DD_ONE(dd);
   zero = Cudd_Not(one);
 
@@ -1158,6 +1238,8 @@ cuddauxAddBddAndAbstractRecur(DdManager * dd,
   unsigned int topf, topg, topcube, top, index;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->commonexistand);
   one = DD_ONE(dd);
   zero = Cudd_Not(one);
 
@@ -1293,6 +1375,8 @@ cuddauxAddApplyBddAndAbstractRecur(DdManager * dd,
   unsigned int topf, topg, topcube, top, index;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->commonexistandop1);
   one = DD_ONE(dd);
   zero = Cudd_Not(one);
 
@@ -1435,3 +1519,90 @@ bddCheckPositiveCube(
     return(0);
 
 } /* end of bddCheckPositiveCube */
+
+/**Function********************************************************************
+
+  Synopsis    [Performs the recursive step of Cuddaux_addApplyCollect.]
+
+  Description [Performs the recursive step of Cuddaux_addApplyCollect.
+  Returns 1 if successful; 0 otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_addApplyCollect]
+
+******************************************************************************/
+static int
+cuddauxAddApplyCollectRecur(DdManager* dd,
+			    struct common* common,
+			    DdHashTable* visited,
+			    int arityBdd,
+			    DdNode** tab,
+			    bool commutative,
+			    int (*visit)(DdManager*, void*, DdNode**),
+			    void* env)
+{
+  DdNode *t, **tab2;
+  DdNode* tab1[2];
+  unsigned int index;
+  int res;
+  const int size = common->arity;
+
+  statLine(dd);
+  if (commutative && tab[0]>tab[1]){
+    tab1[0] = tab[1]; tab1[1] = tab[0];
+    tab = tab1;
+  }
+  /* Already explored or computed ? */
+  switch (size){
+  case 1:
+    t = cuddHashTableLookup1(visited,tab[0]);
+    break;
+  case 2:
+    t = cuddHashTableLookup2(visited,tab[0],tab[1]);
+    break;
+  case 3:
+    t = cuddHashTableLookup3(visited,tab[0],tab[1],tab[2]);
+    break;
+  default:
+    t = cuddHashTableLookup(visited,tab);
+  }
+  if (t != NULL) return 1;
+  if (common->memo.discr != Hash &&
+      cuddauxCommonLookupN(common,tab) != NULL)
+    return 1;
+
+  res = visit(dd,env,tab);
+  if (res<0) return 0;
+  if (res>0){
+    index = array_topindex(dd,tab,size);
+    if (index!=CUDD_CONST_INDEX){
+      tab2 = malloc(size*sizeof(DdNode*));
+      if (tab2==NULL){ dd->errorCode = CUDD_MEMORY_OUT; return 0; }
+      array_then(dd,tab2,tab,index,arityBdd,size);
+      res = cuddauxAddApplyCollectRecur(dd,common,visited,arityBdd,tab2,commutative,visit,env);
+      if (res){
+	array_else(dd,tab2,tab,index,arityBdd,size);
+	res = cuddauxAddApplyCollectRecur(dd,common,visited,arityBdd,tab2,commutative,visit,env);
+      }
+      free(tab2);
+      if (!res) return 0;
+    }
+  }
+  /* Mark the tuple as explored */
+  t = DD_ONE(dd);
+  switch (size){
+  case 1:
+    res = cuddHashTableInsert1(visited,tab[0],t,(ptrint)DD_MAXREF);
+    break;
+  case 2:
+    res = cuddHashTableInsert2(visited,tab[0],tab[1],t,(ptrint)DD_MAXREF);
+    break;
+  case 3:
+    res = cuddHashTableInsert3(visited,tab[0],tab[1],tab[2],t,(ptrint)DD_MAXREF);
+    break;
+  default:
+    res = cuddHashTableInsert(visited,tab,t,(ptrint)DD_MAXREF);
+  }
+  return res;
+} /* end of cuddauxAddApplyCollectRecur */
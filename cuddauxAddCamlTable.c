@@ -36,7 +36,6 @@
 #include "caml/memory.h"
 
 extern intnat caml_stat_compactions;
-static intnat old_compactions = -1;
 
 typedef union myhack {
     value value;
@@ -71,6 +70,7 @@ Cuddaux_addCamlConst(DdManager * unique,
   DdNodePtr *nodelist;
   DdNode *looking;
   myhack split;
+  struct CuddauxMan* man = cuddauxManOfDd(unique);
 
   if (
       value==((struct CuddauxDdNode*)unique->one)->type.value ||
@@ -92,14 +92,14 @@ Cuddaux_addCamlConst(DdManager * unique,
       (void) cuddGarbageCollect(unique,1);
     } else {
       cuddauxAddCamlConstRehash(unique,1);
-      old_compactions = caml_stat_compactions;
+      man->old_compactions = caml_stat_compactions;
     }
   }
 
-  if (0<=old_compactions && old_compactions < caml_stat_compactions){
+  if (0<=man->old_compactions && man->old_compactions < caml_stat_compactions){
     cuddauxAddCamlConstRehash(unique,0);
   }
-  old_compactions = caml_stat_compactions;
+  man->old_compactions = caml_stat_compactions;
 
   split.bits[0] = split.bits[1] = 0;
   split.value = value >> 2;
@@ -120,6 +120,8 @@ Cuddaux_addCamlConst(DdManager * unique,
 #endif
   }
 
+  /* Give up before the counters of keys are updated. */
+  if (cuddGiveUp(unique)) { looking = NULL; goto Cuddaux_addCamlConst_exit; }
   unique->keys++;
   unique->constants.keys++;
 
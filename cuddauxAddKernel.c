@@ -0,0 +1,553 @@
+/**CFile***********************************************************************
+
+  FileName    [cuddauxAddKernel.c]
+
+  PackageName [cuddaux]
+
+  Synopsis    [Predefined leaf operations on ADDs with double leaves.]
+
+  Description [Native terminal cases for Cuddaux_addApply1(),
+	       Cuddaux_addApply2() and Cuddaux_addApplyN(), which work
+	       directly on the double values of the leaves, and a
+	       variation of Cuddaux_addApply2() comparing the leaves of
+	       two ADDs and returning a BDD.
+
+	    External procedures included in this module:
+		<ul>
+		<li> Cuddaux_addKernel1()
+		<li> Cuddaux_addKernel2()
+		<li> Cuddaux_addBddCompare()
+		<li> Cuddaux_addKernelN()
+		</ul>
+	    Internal procedures included in this module:
+		<ul>
+		<li> cuddauxAddBddCompareRecur()
+		</ul>
+		]
+
+  Author      [Bertrand Jeannet]
+
+  Copyright   []
+
+******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "cuddInt.h"
+#include "util.h"
+#include "st.h"
+
+#include "cuddaux.h"
+
+/**AutomaticStart*************************************************************/
+
+/*---------------------------------------------------------------------------*/
+/* Static function prototypes                                                */
+/*---------------------------------------------------------------------------*/
+static DdNode* cuddauxKernel1(DdManager* dd, struct op1* op, DdNode* f);
+static DdNode* cuddauxKernel2(DdManager* dd, struct op2* op, DdNode* f, DdNode* g);
+static DdNode* cuddauxKernelN(DdManager* dd, struct opN* op, DdNode** tab);
+static bool cuddauxKernelCompare(enum cuddaux_kernel kind, CUDD_VALUE_TYPE x, CUDD_VALUE_TYPE y);
+
+/**AutomaticEnd***************************************************************/
+
+/*---------------------------------------------------------------------------*/
+/* Definition of exported functions                                          */
+/*---------------------------------------------------------------------------*/
+
+/**Function********************************************************************
+
+  Synopsis    [Applies a predefined unary kernel to the leaves of f.]
+
+  Description [Applies the kernel op->kind, with parameters op->param,
+  to the leaves of f, with the memoization policy given by
+  op->op1.common1. Fields of op->op1 other than common1 are filled by
+  the function. Returns a pointer to the result if successful; NULL
+  otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_addApply1]
+
+******************************************************************************/
+DdNode *
+Cuddaux_addKernel1(struct kernel1* op,
+		   DdNode * f)
+{
+  assert(op->kind<CUDDAUX_KERNEL_SAT_ADD);
+  op->op1.common1.exn = Val_unit;
+  op->op1.common1.batch = NULL;
+  op->op1.closure1 = Val_unit;
+  op->op1.batch1 = false;
+  op->op1.funptr1 = &cuddauxKernel1;
+  return Cuddaux_addApply1(&op->op1,f);
+} /* end of Cuddaux_addKernel1 */
+
+/**Function********************************************************************
+
+  Synopsis    [Applies a predefined binary kernel to the leaves of f and g.]
+
+  Description [Applies the kernel op->kind, with parameters op->param,
+  to the corresponding leaves of f and g, with the memoization policy
+  given by op->op2.common2. Fields of op->op2 other than common2 are
+  filled by the function. Returns a pointer to the result if
+  successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_addApply2]
+
+******************************************************************************/
+DdNode *
+Cuddaux_addKernel2(struct kernel2* op,
+		   DdNode * f,
+		   DdNode * g)
+{
+  assert(op->kind>=CUDDAUX_KERNEL_SAT_ADD && op->kind<CUDDAUX_KERNEL_LT);
+  op->op2.common2.exn = Val_unit;
+  op->op2.common2.batch = NULL;
+  op->op2.closure2 = Val_unit;
+  op->op2.ospecial2 = Val_unit;
+  op->op2.commutative =
+    op->kind==CUDDAUX_KERNEL_SAT_ADD ||
+    (op->kind==CUDDAUX_KERNEL_AFFINE2 && op->param[0]==op->param[1]);
+  op->op2.idempotent = false;
+  op->op2.batch2 = false;
+  op->op2.funptr2 = &cuddauxKernel2;
+  return Cuddaux_addApply2(&op->op2,f,g);
+} /* end of Cuddaux_addKernel2 */
+
+/**Function********************************************************************
+
+  Synopsis    [Compares the corresponding leaves of f and g.]
+
+  Description [Returns the BDD of the valuations for which the leaf of f
+  and the leaf of g are related by the comparison op->kind, with the
+  memoization policy given by op->op2.common2. Returns a pointer to the
+  result if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_addKernel2]
+
+******************************************************************************/
+DdNode *
+Cuddaux_addBddCompare(struct kernel2* op,
+		      DdNode * f,
+		      DdNode * g)
+{
+  DdNode *res;
+  DdManager* dd = op->op2.common2.man->man;
+  double allocated = dd->allocated;
+
+  assert(op->kind>=CUDDAUX_KERNEL_LT);
+  op->op2.common2.exn = Val_unit;
+  op->op2.common2.batch = NULL;
+  op->op2.closure2 = Val_unit;
+  op->op2.ospecial2 = Val_unit;
+  op->op2.commutative =
+    op->kind==CUDDAUX_KERNEL_EQ || op->kind==CUDDAUX_KERNEL_NE;
+  op->op2.idempotent = false;
+  op->op2.batch2 = false;
+  op->op2.funptr2 = NULL;
+  do {
+    dd->reordered = 0;
+    if (cuddauxCommonReinit(&op->op2.common2)==NULL) return NULL;
+    res = cuddauxAddBddCompareRecur(dd,op,f,g);
+  } while (dd->reordered == 1);
+  cuddauxProfileCall(&op->op2.common2,allocated);
+  return(res);
+} /* end of Cuddaux_addBddCompare */
+
+/**Function********************************************************************
+
+  Synopsis    [Evaluates a compiled expression on the leaves of tab.]
+
+  Description [Applies the expression compiled in op->code (see enum
+  cuddaux_expr), with constants op->csts and registers op->regs (which
+  allow to share subexpressions), to the corresponding leaves of
+  the elements of tab, with the memoization policy given by
+  op->opN.commonN. The first op->opN.arityNbdd elements of tab are BDDs.
+  Fields of op->opN other than commonN and arityNbdd are filled by the
+  function. Returns a pointer to the result if successful; NULL
+  otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_addApplyN]
+
+******************************************************************************/
+DdNode *
+Cuddaux_addKernelN(struct kernelN* op,
+		   DdNode ** tab)
+{
+  op->opN.commonN.exn = Val_unit;
+  op->opN.commonN.batch = NULL;
+  op->opN.closureN = Val_unit;
+  op->opN.batchN = false;
+  op->opN.funptrN = &cuddauxKernelN;
+  return Cuddaux_addApplyN(&op->opN,tab);
+} /* end of Cuddaux_addKernelN */
+
+/*---------------------------------------------------------------------------*/
+/* Definition of internal functions                                          */
+/*---------------------------------------------------------------------------*/
+
+/**Function********************************************************************
+
+  Synopsis    [Performs the recursive step of Cuddaux_addBddCompare.]
+
+  Description [Performs the recursive step of Cuddaux_addBddCompare.
+  Returns a pointer to the result if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [cuddauxAddApply2Recur]
+
+******************************************************************************/
+DdNode *
+cuddauxAddBddCompareRecur(DdManager * dd,
+			  struct kernel2* op,
+			  DdNode * f,
+			  DdNode * g)
+{
+  DdNode *res, *one,
+    *fv, *fvn, *gv, *gvn,
+    *T, *E;
+  unsigned int ford, gord;
+  unsigned int index;
+
+  statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(&op->op2.common2);
+  assert (f->ref>=1);
+  assert (g->ref>=1);
+
+  one = DD_ONE(dd);
+  /* A leaf is not necessarily equal to itself (NaN), so that f==g
+     decides the comparison only on constants, from their value */
+  if (f==g && cuddIsConstant(f)){
+    return cuddauxKernelCompare(op->kind,cuddV(f),cuddV(f)) ? one : Cudd_Not(one);
+  }
+  if (op->op2.commutative && f>g){
+    DdNode* t = f; f=g; g=t;
+  }
+  /* Check cache. */
+  res = cuddauxCommonLookup2(&op->op2.common2,f,g);
+  if (res != NULL) return res;
+
+  /* Check terminal cases. */
+  if (cuddIsConstant(f) && cuddIsConstant(g)){
+    res = cuddauxKernelCompare(op->kind,cuddV(f),cuddV(g)) ? one : Cudd_Not(one);
+    goto cuddauxAddBddCompareRecur_end;
+  }
+
+  /* Recursive step. */
+  ford = cuddI(dd,f->index);
+  gord = cuddI(dd,g->index);
+  if (ford <= gord) {
+    index = f->index;
+    fv = cuddT(f);
+    fvn = cuddE(f);
+  } else {
+    index = g->index;
+    fv = fvn = f;
+  }
+  if (gord <= ford) {
+    gv = cuddT(g);
+    gvn = cuddE(g);
+  } else {
+    gv = gvn = g;
+  }
+
+  T = cuddauxAddBddCompareRecur(dd,op,fv,gv);
+  if (T == NULL) return(NULL);
+  cuddRef(T);
+
+  E = cuddauxAddBddCompareRecur(dd,op,fvn,gvn);
+  if (E == NULL) {
+    Cudd_IterDerefBdd(dd,T);
+    return(NULL);
+  }
+  cuddRef(E);
+
+  if (T == E) {
+    res = T;
+  }
+  else if (Cudd_IsComplement(T)) {
+    res = cuddUniqueInter(dd,(int)index,Cudd_Not(T),Cudd_Not(E));
+    if (res == NULL) {
+      Cudd_IterDerefBdd(dd, T);
+      Cudd_IterDerefBdd(dd, E);
+      return(NULL);
+    }
+    res = Cudd_Not(res);
+  }
+  else {
+    res = cuddUniqueInter(dd,(int)index,T,E);
+    if (res == NULL) {
+      Cudd_IterDerefBdd(dd, T);
+      Cudd_IterDerefBdd(dd, E);
+      return(NULL);
+    }
+  }
+  cuddDeref(T);
+  cuddDeref(E);
+
+  /* Store result. */
+ cuddauxAddBddCompareRecur_end:
+  return cuddauxCommonInsert2(&op->op2.common2,f,g,res);
+} /* end of cuddauxAddBddCompareRecur */
+
+/*---------------------------------------------------------------------------*/
+/* Definition of static functions                                            */
+/*---------------------------------------------------------------------------*/
+
+/**Function********************************************************************
+
+  Synopsis    [Terminal case of Cuddaux_addKernel1.]
+
+  Description [Returns the constant obtained by applying the kernel to
+  the leaf f, f itself if the kernel is the identity, or NULL if f is
+  not a leaf.]
+
+  SideEffects [None]
+
+  SeeAlso     []
+
+******************************************************************************/
+static DdNode*
+cuddauxKernel1(DdManager* dd, struct op1* op, DdNode* f)
+{
+  struct kernel1* k = (struct kernel1*)op;
+  CUDD_VALUE_TYPE x, res;
+
+  if (k->kind==CUDDAUX_KERNEL_AFFINE && k->param[0]==1.0 && k->param[1]==0.0)
+    return f;
+  if (k->kind==CUDDAUX_KERNEL_POW && k->param[0]==1.0)
+    return f;
+  if (!cuddIsConstant(f))
+    return NULL;
+
+  x = cuddV(f);
+  switch (k->kind){
+  case CUDDAUX_KERNEL_AFFINE:
+    res = k->param[0]*x + k->param[1];
+    break;
+  case CUDDAUX_KERNEL_CLAMP:
+    res = x<k->param[0] ? k->param[0] : (x>k->param[1] ? k->param[1] : x);
+    break;
+  case CUDDAUX_KERNEL_ABS:
+    res = fabs(x);
+    break;
+  case CUDDAUX_KERNEL_POW:
+    res = pow(x,k->param[0]);
+    break;
+  case CUDDAUX_KERNEL_MIN_CST:
+    res = x<=k->param[0] ? x : k->param[0];
+    break;
+  case CUDDAUX_KERNEL_MAX_CST:
+    res = x>=k->param[0] ? x : k->param[0];
+    break;
+  default:
+    abort();
+  }
+  return cuddUniqueConst(dd,res);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Terminal case of Cuddaux_addKernel2.]
+
+  Description [Returns the constant obtained by applying the kernel to
+  the leaves f and g, or NULL if the recursion has to go on.]
+
+  SideEffects [None]
+
+  SeeAlso     []
+
+******************************************************************************/
+static DdNode*
+cuddauxKernel2(DdManager* dd, struct op2* op, DdNode* f, DdNode* g)
+{
+  struct kernel2* k = (struct kernel2*)op;
+  CUDD_VALUE_TYPE x, y, res;
+
+  if (k->kind==CUDDAUX_KERNEL_POWER){
+    /* x**1 = x and 1**y = 1 */
+    if (g==DD_ONE(dd) || f==DD_ONE(dd))
+      return f;
+  }
+  if (!cuddIsConstant(f) || !cuddIsConstant(g))
+    return NULL;
+
+  x = cuddV(f);
+  y = cuddV(g);
+  switch (k->kind){
+  case CUDDAUX_KERNEL_SAT_ADD:
+    res = x + y;
+    res = res<k->param[0] ? k->param[0] : (res>k->param[1] ? k->param[1] : res);
+    break;
+  case CUDDAUX_KERNEL_AFFINE2:
+    res = k->param[0]*x + k->param[1]*y + k->param[2];
+    break;
+  case CUDDAUX_KERNEL_POWER:
+    res = pow(x,y);
+    break;
+  default:
+    abort();
+  }
+  return cuddUniqueConst(dd,res);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Terminal case of Cuddaux_addKernelN.]
+
+  Description [Returns the constant obtained by evaluating the compiled
+  expression on the leaves of tab, or NULL if one element of tab is not
+  a leaf.]
+
+  SideEffects [None]
+
+  SeeAlso     []
+
+******************************************************************************/
+static DdNode*
+cuddauxKernelN(DdManager* dd, struct opN* op, DdNode** tab)
+{
+  struct kernelN* k = (struct kernelN*)op;
+  DdNode** tadd = tab + op->arityNbdd;
+  DdNode* one = DD_ONE(dd);
+  const int* pc = k->code;
+  const int* end = k->code + k->codesize;
+  double* sp = k->stack;
+  int i;
+
+  for (i=0; i<op->commonN.arity; i++){
+    if (!cuddIsConstant(Cudd_Regular(tab[i])))
+      return NULL;
+  }
+  while (pc<end){
+    switch (*pc++){
+    case CUDDAUX_EXPR_VAR:
+      *sp++ = cuddV(tadd[*pc++]);
+      break;
+    case CUDDAUX_EXPR_BVAR:
+      *sp++ = tab[*pc++]==one ? 1.0 : 0.0;
+      break;
+    case CUDDAUX_EXPR_CST:
+      *sp++ = k->csts[*pc++];
+      break;
+    case CUDDAUX_EXPR_NEG:
+      sp[-1] = -sp[-1];
+      break;
+    case CUDDAUX_EXPR_ABS:
+      sp[-1] = fabs(sp[-1]);
+      break;
+    case CUDDAUX_EXPR_ADD:
+      sp--; sp[-1] = sp[-1] + sp[0];
+      break;
+    case CUDDAUX_EXPR_SUB:
+      sp--; sp[-1] = sp[-1] - sp[0];
+      break;
+    case CUDDAUX_EXPR_MUL:
+      sp--; sp[-1] = sp[-1] * sp[0];
+      break;
+    case CUDDAUX_EXPR_DIV:
+      sp--; sp[-1] = sp[-1] / sp[0];
+      break;
+    case CUDDAUX_EXPR_MIN:
+      sp--; if (sp[0] < sp[-1]) sp[-1] = sp[0];
+      break;
+    case CUDDAUX_EXPR_MAX:
+      sp--; if (sp[0] > sp[-1]) sp[-1] = sp[0];
+      break;
+    case CUDDAUX_EXPR_LT:
+      sp--; sp[-1] = sp[-1] < sp[0] ? 1.0 : 0.0;
+      break;
+    case CUDDAUX_EXPR_LE:
+      sp--; sp[-1] = sp[-1] <= sp[0] ? 1.0 : 0.0;
+      break;
+    case CUDDAUX_EXPR_EQ:
+      sp--; sp[-1] = sp[-1] == sp[0] ? 1.0 : 0.0;
+      break;
+    case CUDDAUX_EXPR_NOT:
+      sp[-1] = sp[-1] == 0.0 ? 1.0 : 0.0;
+      break;
+    case CUDDAUX_EXPR_SELECT:
+      sp -= 2; sp[-1] = sp[-1] != 0.0 ? sp[0] : sp[1];
+      break;
+    case CUDDAUX_EXPR_LOAD:
+      *sp++ = k->regs[*pc++];
+      break;
+    case CUDDAUX_EXPR_STORE:
+      k->regs[*pc++] = *--sp;
+      break;
+    case CUDDAUX_EXPR_CUDD_PLUS:
+      sp--;
+      if (sp[-1]==0.0) sp[-1] = sp[0];
+      else if (sp[0]!=0.0) sp[-1] = sp[-1] + sp[0];
+      break;
+    case CUDDAUX_EXPR_CUDD_MINUS:
+      sp--;
+      if (sp[-1]==sp[0]) sp[-1] = 0.0;
+      else if (sp[-1]==0.0) sp[-1] = -sp[0];
+      else if (sp[0]!=0.0) sp[-1] = sp[-1] - sp[0];
+      break;
+    case CUDDAUX_EXPR_CUDD_TIMES:
+      sp--;
+      if (sp[-1]==0.0 || sp[0]==0.0) sp[-1] = 0.0;
+      else if (sp[-1]==1.0) sp[-1] = sp[0];
+      else if (sp[0]!=1.0) sp[-1] = sp[-1] * sp[0];
+      break;
+    case CUDDAUX_EXPR_CUDD_DIVIDE:
+      sp--;
+      if (sp[-1]==0.0) sp[-1] = 0.0;
+      else if (sp[0]!=1.0) sp[-1] = sp[-1] / sp[0];
+      break;
+    case CUDDAUX_EXPR_CUDD_MINIMUM:
+      sp--;
+      if (sp[-1]==DD_PLUS_INF_VAL) sp[-1] = sp[0];
+      else if (sp[0]!=DD_PLUS_INF_VAL && sp[-1]!=sp[0] && !(sp[-1] <= sp[0]))
+	sp[-1] = sp[0];
+      break;
+    case CUDDAUX_EXPR_CUDD_MAXIMUM:
+      sp--;
+      if (sp[-1]!=sp[0]){
+	if (sp[-1]==DD_MINUS_INF_VAL) sp[-1] = sp[0];
+	else if (sp[0]!=DD_MINUS_INF_VAL && !(sp[-1] >= sp[0])) sp[-1] = sp[0];
+      }
+      break;
+    default:
+      abort();
+    }
+  }
+  assert(sp == k->stack+1);
+  return cuddUniqueConst(dd,sp[-1]);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Compares two leaf values.]
+
+  SideEffects [None]
+
+  SeeAlso     []
+
+******************************************************************************/
+static bool
+cuddauxKernelCompare(enum cuddaux_kernel kind, CUDD_VALUE_TYPE x, CUDD_VALUE_TYPE y)
+{
+  switch (kind){
+  case CUDDAUX_KERNEL_LT: return x<y;
+  case CUDDAUX_KERNEL_LE: return x<=y;
+  case CUDDAUX_KERNEL_EQ: return x==y;
+  case CUDDAUX_KERNEL_NE: return x!=y;
+  case CUDDAUX_KERNEL_GE: return x>=y;
+  case CUDDAUX_KERNEL_GT: return x>y;
+  default: abort();
+  }
+}
@@ -14,6 +14,11 @@
 		<li> Cuddaux_SetVarMap()
 		<li> Cuddaux_addVectorCompose()
 		<li> Cuddaux_addApplyVectorCompose()
+		<li> Cuddaux_VectorComposeArrayCommon()
+		<li> Cuddaux_PermuteArrayCommon()
+		<li> Cuddaux_SparseComposeArrayCommon()
+		<li> Cuddaux_bddAndAbstractVarMap()
+		<li> Cuddaux_bddAndAbstractVarMapVector()
 		</ul>
 	       Internal procedures included in this module:
 		<ul>
@@ -24,6 +29,11 @@
 		<li> cuddauxAddVarMapRecur()
 		<li> cuddauxAddVectorComposeRecur()
 		<li> CuddauxAddApplyVectorCompose()
+		<li> cuddauxBddAndAbstractVarMapRecur()
+		<li> cuddauxSubstCompare()
+		<li> cuddauxSubstFind()
+		<li> cuddauxBddSparseComposeRecur()
+		<li> cuddauxAddSparseComposeRecur()
 	       </ul>
   The permutation functions use a local cache because the results to
   be remembered depend on the permutation being applied.  Since the
@@ -48,6 +58,14 @@
 
 #include "cuddaux.h"
 
+static DdNode* cuddauxBddAndAbstractVarMapRecur(DdManager* dd, DdNode* f, DdNode* g, DdNode* cube);
+static int cuddauxSubstCompare(const void* a, const void* b);
+static DdNode* cuddauxSubstFind(DdManager* dd, struct CuddauxSubst* subst, int nsubst, int index);
+static DdNode* cuddauxBddSparseComposeRecur(struct common* common, DdNode* f,
+					    struct CuddauxSubst* subst, int nsubst, int deepest);
+static DdNode* cuddauxAddSparseComposeRecur(struct common* common, DdNode* f,
+					    struct CuddauxSubst* subst, int nsubst, int deepest);
+
 /*---------------------------------------------------------------------------*/
 /* Definition of exported functions                                          */
 /*---------------------------------------------------------------------------*/
@@ -197,22 +215,10 @@ Cuddaux_bddVectorComposeCommon(struct common* common,
 			       DdNode ** vector)
 {
   DdNode *res;
-  DdManager* dd = common->man->man;
-  int i, deepest;
 
-  do {
-    dd->reordered = 0;
-    if (cuddauxCommonReinit(common)==NULL) return NULL;
-    /* Find deepest real substitution. */
-    for (deepest = dd->size - 1; deepest >= 0; deepest--) {
-      i = dd->invperm[deepest];
-      if (vector[i] != dd->vars[i]) {
-	break;
-      }
-    }
-    /* Recursively solve the problem. */
-    res = cuddauxBddVectorComposeRecur(common,f,vector,deepest);
-  } while (dd->reordered == 1);
+  if (!Cuddaux_VectorComposeArrayCommon(common,true,&f,1,vector,&res))
+    return(NULL);
+  cuddDeref(res);
   return(res);
 } /* end of Cuddaux_bddVectorComposeCommon */
 
@@ -221,26 +227,12 @@ Cuddaux_bddPermuteCommon(struct common* common,
 			 DdNode* f,
 			 int* permut)
 {
-  DdManager* dd = common->man->man;
-  const int size = dd->size;
-  DdNode** vector;
-  DdNode* res;
-  int i;
+  DdNode *res;
 
-  vector = malloc(dd->size*sizeof(DdNode*));
-  for (i=0; i<size;i++){
-    int j = permut[i];
-    if (j<0 || j>=size){
-      fprintf(stderr,"mlcuddidl: error, permutation contains a not yet existing BDD index %d\n",j);
-      free(vector);
-      dd->errorCode = CUDD_INVALID_ARG;
-      return NULL;
-    }
-    vector[i] = dd->vars[j];
-  }
-  res = Cuddaux_bddVectorComposeCommon(common,f,vector);
-  free(vector);
-  return res;
+  if (!Cuddaux_PermuteArrayCommon(common,true,&f,1,permut,&res))
+    return(NULL);
+  cuddDeref(res);
+  return(res);
 }
 
 /**Function********************************************************************
@@ -268,12 +260,57 @@ Cuddaux_addVectorComposeCommon(struct common* common,
 			       DdNode ** vector)
 {
   DdNode *res;
+
+  if (!Cuddaux_VectorComposeArrayCommon(common,false,&f,1,vector,&res))
+    return(NULL);
+  cuddDeref(res);
+  return(res);
+} /* end of Cudd_addVectorCompose */
+
+DdNode*
+Cuddaux_addPermuteCommon(struct common* common,
+			 DdNode* f,
+			 int* permut)
+{
+  DdNode *res;
+
+  if (!Cuddaux_PermuteArrayCommon(common,false,&f,1,permut,&res))
+    return(NULL);
+  cuddDeref(res);
+  return(res);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Composes an array of BDDs or ADDs with a vector of BDDs.]
+
+  Description [Applies the vector composition of
+  Cuddaux_bddVectorComposeCommon (if bdd is true) or
+  Cuddaux_addVectorComposeCommon to each of the size diagrams of tf,
+  with the same memoization table and depth of the deepest
+  substitution, so that the intermediate results are shared between
+  the roots. If a reordering occurs, all the roots are recomputed.
+
+  Returns 1 if successful, with the results (referenced) in tres; 0
+  otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_bddVectorComposeCommon Cuddaux_addVectorComposeCommon]
+
+******************************************************************************/
+int
+Cuddaux_VectorComposeArrayCommon(struct common* common, bool bdd,
+				 DdNode** tf, int size,
+				 DdNode** vector, DdNode** tres)
+{
   DdManager* dd = common->man->man;
-  int i, deepest;
+  double allocated = dd->allocated;
+  int i, j, deepest;
 
   do {
     dd->reordered = 0;
-    if (cuddauxCommonReinit(common)==NULL) return NULL;
+    if (cuddauxCommonReinit(common)==NULL) return(0);
     /* Find deepest real substitution. */
     for (deepest = dd->size - 1; deepest >= 0; deepest--) {
       i = dd->invperm[deepest];
@@ -281,37 +318,127 @@ Cuddaux_addVectorComposeCommon(struct common* common,
 	break;
       }
     }
-    /* Recursively solve the problem. */
-    res = cuddauxAddVectorComposeRecur(common,f,vector,deepest);
+    /* Recursively solve the problem for each root. */
+    for (i=0; i<size; i++){
+      tres[i] = bdd ?
+	cuddauxBddVectorComposeRecur(common,tf[i],vector,deepest) :
+	cuddauxAddVectorComposeRecur(common,tf[i],vector,deepest);
+      if (tres[i]==NULL) break;
+      cuddRef(tres[i]);
+    }
+    if (i<size){
+      for (j=0; j<i; j++)
+	Cudd_RecursiveDeref(dd,tres[j]);
+    }
   } while (dd->reordered == 1);
-  return(res);
-} /* end of Cudd_addVectorCompose */
+  cuddauxProfileCall(common,allocated);
+  return(i==size);
+}
 
-DdNode*
-Cuddaux_addPermuteCommon(struct common* common,
-			 DdNode* f,
-			 int* permut)
+/**Function********************************************************************
+
+  Synopsis    [Permutes the variables of an array of BDDs or ADDs.]
+
+  Description [Same as Cuddaux_VectorComposeArrayCommon, with the
+  vector of projection functions defined by the permutation permut,
+  which should have an entry for each variable in the manager.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_VectorComposeArrayCommon]
+
+******************************************************************************/
+int
+Cuddaux_PermuteArrayCommon(struct common* common, bool bdd,
+			   DdNode** tf, int size,
+			   int* permut, DdNode** tres)
 {
   DdManager* dd = common->man->man;
-  const int size = dd->size;
+  const int nvars = dd->size;
   DdNode** vector;
-  DdNode* res;
-  int i;
+  int i,res;
 
-  vector = malloc(dd->size*sizeof(DdNode*));
-  for (i=0; i<size;i++){
+  vector = malloc(nvars*sizeof(DdNode*));
+  for (i=0; i<nvars;i++){
     int j = permut[i];
-    if (j<0 || j>=size){
+    if (j<0 || j>=nvars){
       fprintf(stderr,"mlcuddidl: error, permutation contains a not yet existing BDD index %d\n",j);
       free(vector);
       dd->errorCode = CUDD_INVALID_ARG;
-      return NULL;
+      return(0);
     }
     vector[i] = dd->vars[j];
   }
-  res = Cuddaux_addVectorComposeCommon(common,f,vector);
+  res = Cuddaux_VectorComposeArrayCommon(common,bdd,tf,size,vector,tres);
   free(vector);
-  return res;
+  return(res);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Composes an array of BDDs or ADDs with a sparse substitution.]
+
+  Description [Same as Cuddaux_VectorComposeArrayCommon, but the
+  substitution is given by the nsubst entries of subst instead of a
+  vector with an entry for each variable of the manager; the other
+  variables are left unchanged. The entries are sorted by level of
+  their variable, so that the substituted function of a node is found
+  by a binary search, and the cost of a call does not depend on the
+  number of variables in the manager.
+
+  Returns 1 if successful, with the results (referenced) in tres; 0
+  otherwise, with the error code CUDD_INVALID_ARG if a variable appears
+  twice in subst.]
+
+  SideEffects [Sorts subst and sets the level field of its entries.]
+
+  SeeAlso     [Cuddaux_VectorComposeArrayCommon]
+
+******************************************************************************/
+int
+Cuddaux_SparseComposeArrayCommon(struct common* common, bool bdd,
+				 DdNode** tf, int size,
+				 struct CuddauxSubst* subst, int nsubst,
+				 DdNode** tres)
+{
+  DdManager* dd = common->man->man;
+  double allocated = dd->allocated;
+  int i, j, deepest;
+
+  do {
+    dd->reordered = 0;
+    if (cuddauxCommonReinit(common)==NULL) return(0);
+    /* Sort the substitution by level, and find the deepest real
+       substitution. */
+    for (i=0; i<nsubst; i++){
+      subst[i].level = dd->perm[subst[i].index];
+    }
+    qsort(subst, nsubst, sizeof(struct CuddauxSubst), cuddauxSubstCompare);
+    for (i=1; i<nsubst; i++){
+      if (subst[i].level == subst[i-1].level){
+	dd->errorCode = CUDD_INVALID_ARG;
+	return(0);
+      }
+    }
+    for (i = nsubst-1; i >= 0; i--){
+      if (subst[i].func != dd->vars[subst[i].index]) break;
+    }
+    deepest = i>=0 ? subst[i].level : -1;
+    /* Recursively solve the problem for each root. */
+    for (i=0; i<size; i++){
+      tres[i] = bdd ?
+	cuddauxBddSparseComposeRecur(common,tf[i],subst,nsubst,deepest) :
+	cuddauxAddSparseComposeRecur(common,tf[i],subst,nsubst,deepest);
+      if (tres[i]==NULL) break;
+      cuddRef(tres[i]);
+    }
+    if (i<size){
+      for (j=0; j<i; j++)
+	Cudd_RecursiveDeref(dd,tres[j]);
+    }
+  } while (dd->reordered == 1);
+  cuddauxProfileCall(common,allocated);
+  return(i==size);
 }
 
 DdNode *
@@ -324,7 +451,7 @@ Cuddaux_addVectorCompose(
   struct common common;
   struct CuddauxHash hash;
   DdNode* res;
-  common.pid = 0;
+  common.pid = &man->builtin[CUDDAUX_ADD_VECTORCOMPOSE];
   common.arity = 1;
   common.memo.discr = Hash;
   common.memo.u.hash = &hash;
@@ -333,6 +460,8 @@ Cuddaux_addVectorCompose(
   hash.arity = 1;
   hash.initialsize = 0;
   hash.man = NULL;
+  hash.pins = NULL;
+  hash.npins = 0;
   res = Cuddaux_addVectorComposeCommon(&common,f,vector);
   if (res!=NULL) cuddRef(res);
   cuddauxCommonClear(&common);
@@ -340,6 +469,80 @@ Cuddaux_addVectorCompose(
   return res;
 }
 
+/**Function********************************************************************
+
+  Synopsis    [Conjunction, existential abstraction and variable remapping
+  of BDDs.]
+
+  Description [Computes Cudd_bddVarMap(Cudd_bddAndAbstract(f,g,cube))
+  in a single recursion, without building the intermediate result
+  before remapping. The variable map must be registered with
+  Cudd(aux)_SetVarMap. Results are cached in the global computed
+  table, which is flushed when the map is changed. Returns a pointer
+  to the result if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cudd_bddAndAbstract Cudd_bddVarMap Cuddaux_SetVarMap]
+
+******************************************************************************/
+DdNode*
+Cuddaux_bddAndAbstractVarMap(DdManager* dd, DdNode* f, DdNode* g, DdNode* cube)
+{
+  DdNode* res;
+
+  if (dd->map == NULL) return(NULL);
+  do {
+    dd->reordered = 0;
+    res = cuddauxBddAndAbstractVarMapRecur(dd, f, g, cube);
+  } while (dd->reordered == 1);
+  return(res);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Relational product of a BDD with a partitioned relation,
+  followed by variable remapping.]
+
+  Description [Computes successively f_{i+1} = Cudd_bddAndAbstract(f_i,
+  tg[i], tcube[i]) with f_0=f, and remaps the variables of the result
+  with the default variable map. The last step is performed by
+  Cuddaux_bddAndAbstractVarMap. Returns a pointer to the result if
+  successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_bddAndAbstractVarMap]
+
+******************************************************************************/
+DdNode*
+Cuddaux_bddAndAbstractVarMapVector(DdManager* dd, DdNode* f,
+				   DdNode** tg, DdNode** tcube, int size)
+{
+  DdNode *res, *tmp;
+  int i;
+
+  if (dd->map == NULL) return(NULL);
+  if (size==0) return(Cudd_bddVarMap(dd,f));
+  res = f;
+  cuddRef(res);
+  for (i=0; i<size-1 && res!=Cudd_Not(DD_ONE(dd)); i++){
+    tmp = Cudd_bddAndAbstract(dd,res,tg[i],tcube[i]);
+    if (tmp==NULL){
+      Cudd_RecursiveDeref(dd,res);
+      return(NULL);
+    }
+    cuddRef(tmp);
+    Cudd_RecursiveDeref(dd,res);
+    res = tmp;
+  }
+  tmp = Cuddaux_bddAndAbstractVarMap(dd,res,tg[size-1],tcube[size-1]);
+  if (tmp!=NULL) cuddRef(tmp);
+  Cudd_RecursiveDeref(dd,res);
+  if (tmp!=NULL) cuddDeref(tmp);
+  return(tmp);
+}
+
 /*---------------------------------------------------------------------------*/
 /* Definition of internal functions                                          */
 /*---------------------------------------------------------------------------*/
@@ -530,6 +733,7 @@ cuddauxAddVectorComposeRecur(
   DdNode *T,*E;
   DdNode *res;
 
+  cuddauxProfileStep(common);
   /* If we are past the deepest substitution, return f. */
   if (cuddI(dd,f->index) > deepest) {
     return(f);
@@ -590,6 +794,8 @@ cuddauxBddVectorComposeRecur(
   DdNode	*res;
 
   statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(common);
   F = Cudd_Regular(f);
 
   /* If we are past the deepest substitution, return f. */
@@ -632,3 +838,315 @@ cuddauxBddVectorComposeRecur(
   res = Cudd_NotCond(res,F != f);
   return res;
 } /* end of cuddauxBddVectorComposeRecur */
+
+/**Function********************************************************************
+
+  Synopsis    [Performs the recursive step of Cuddaux_bddAndAbstractVarMap.]
+
+  Description [Follows cuddBddAndAbstractRecur, except that the
+  variables which are not abstracted are remapped with
+  cuddBddIteRecur, as in cuddBddVarMapRecur, and that the shortcuts
+  comparing the result to the operands are not valid. Returns a
+  pointer to the result if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_bddAndAbstractVarMap]
+
+******************************************************************************/
+static DdNode*
+cuddauxBddAndAbstractVarMapRecur(DdManager* dd, DdNode* f, DdNode* g, DdNode* cube)
+{
+  DdNode *F, *ft, *fe, *G, *gt, *ge;
+  DdNode *one, *zero, *r, *t, *e;
+  unsigned int topf, topg, topcube, top, index;
+
+  statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  one = DD_ONE(dd);
+  zero = Cudd_Not(one);
+
+  /* Terminal cases. */
+  if (f == zero || g == zero || f == Cudd_Not(g)) return(zero);
+  if (f == one && g == one) return(one);
+  if (f == one) f = g;
+  else if (g == one) g = f;
+  /* At this point f and g are not constant. */
+
+  if (f > g) { /* Try to increase cache efficiency. */
+    DdNode *tmp = f;
+    f = g;
+    g = tmp;
+  }
+  F = Cudd_Regular(f);
+  G = Cudd_Regular(g);
+  topf = dd->perm[F->index];
+  topg = dd->perm[G->index];
+  top = ddMin(topf, topg);
+  topcube = cuddI(dd,cube->index);
+  while (topcube < top) {
+    cube = cuddT(cube);
+    topcube = cuddI(dd,cube->index);
+  }
+  /* Now, topcube >= top. */
+
+  /* Check cache. */
+  if (F->ref != 1 || G->ref != 1) {
+    r = cuddCacheLookup(dd, DDAUX_BDD_AND_ABSTRACT_VARMAP_TAG, f, g, cube);
+    if (r != NULL) {
+      return(r);
+    }
+  }
+
+  if (topf == top) {
+    index = F->index;
+    ft = cuddT(F);
+    fe = cuddE(F);
+    if (Cudd_IsComplement(f)) {
+      ft = Cudd_Not(ft);
+      fe = Cudd_Not(fe);
+    }
+  } else {
+    index = G->index;
+    ft = fe = f;
+  }
+  if (topg == top) {
+    gt = cuddT(G);
+    ge = cuddE(G);
+    if (Cudd_IsComplement(g)) {
+      gt = Cudd_Not(gt);
+      ge = Cudd_Not(ge);
+    }
+  } else {
+    gt = ge = g;
+  }
+
+  if (topcube == top) {	/* quantify */
+    DdNode *Cube = cuddT(cube);
+    t = cuddauxBddAndAbstractVarMapRecur(dd, ft, gt, Cube);
+    if (t == NULL) return(NULL);
+    /* 1 OR anything = 1 */
+    if (t == one) {
+      if (F->ref != 1 || G->ref != 1)
+	cuddCacheInsert(dd, DDAUX_BDD_AND_ABSTRACT_VARMAP_TAG, f, g, cube, t);
+      return(t);
+    }
+    cuddRef(t);
+    e = cuddauxBddAndAbstractVarMapRecur(dd, fe, ge, Cube);
+    if (e == NULL) {
+      Cudd_IterDerefBdd(dd, t);
+      return(NULL);
+    }
+    if (t == e) {
+      r = t;
+      cuddDeref(t);
+    } else {
+      cuddRef(e);
+      r = cuddBddAndRecur(dd, Cudd_Not(t), Cudd_Not(e));
+      if (r == NULL) {
+	Cudd_IterDerefBdd(dd, t);
+	Cudd_IterDerefBdd(dd, e);
+	return(NULL);
+      }
+      r = Cudd_Not(r);
+      cuddRef(r);
+      Cudd_DelayedDerefBdd(dd, t);
+      Cudd_DelayedDerefBdd(dd, e);
+      cuddDeref(r);
+    }
+  } else {
+    t = cuddauxBddAndAbstractVarMapRecur(dd, ft, gt, cube);
+    if (t == NULL) return(NULL);
+    cuddRef(t);
+    e = cuddauxBddAndAbstractVarMapRecur(dd, fe, ge, cube);
+    if (e == NULL) {
+      Cudd_IterDerefBdd(dd, t);
+      return(NULL);
+    }
+    cuddRef(e);
+    /* Remap the variable, as in cuddBddVarMapRecur */
+    r = cuddBddIteRecur(dd, dd->vars[dd->map[index]], t, e);
+    if (r == NULL) {
+      Cudd_IterDerefBdd(dd, t);
+      Cudd_IterDerefBdd(dd, e);
+      return(NULL);
+    }
+    cuddRef(r);
+    Cudd_IterDerefBdd(dd, t);
+    Cudd_IterDerefBdd(dd, e);
+    cuddDeref(r);
+  }
+
+  if (F->ref != 1 || G->ref != 1)
+    cuddCacheInsert(dd, DDAUX_BDD_AND_ABSTRACT_VARMAP_TAG, f, g, cube, r);
+  return(r);
+
+} /* end of cuddauxBddAndAbstractVarMapRecur */
+
+/**Function********************************************************************
+
+  Synopsis    [Compares two entries of a sparse substitution by level.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_SparseComposeArrayCommon]
+
+******************************************************************************/
+static int
+cuddauxSubstCompare(const void* a, const void* b)
+{
+  int la = ((const struct CuddauxSubst*)a)->level;
+  int lb = ((const struct CuddauxSubst*)b)->level;
+  return la<lb ? -1 : (la>lb ? 1 : 0);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Function substituted to a variable by a sparse substitution.]
+
+  Description [Binary search of the level of index in subst, which is
+  sorted by level. Returns the projection function of index if it is
+  not substituted.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_SparseComposeArrayCommon]
+
+******************************************************************************/
+static DdNode*
+cuddauxSubstFind(DdManager* dd, struct CuddauxSubst* subst, int nsubst, int index)
+{
+  int level = dd->perm[index];
+  int low = 0;
+  int high = nsubst-1;
+
+  while (low<=high){
+    int mid = (low+high)/2;
+    if (subst[mid].level < level)
+      low = mid+1;
+    else if (subst[mid].level > level)
+      high = mid-1;
+    else
+      return subst[mid].func;
+  }
+  return dd->vars[index];
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Performs the recursive step of
+  Cuddaux_SparseComposeArrayCommon for BDDs.]
+
+  Description [Same as cuddauxBddVectorComposeRecur, with a sparse
+  substitution.]
+
+  SideEffects [None]
+
+  SeeAlso     [cuddauxBddVectorComposeRecur]
+
+******************************************************************************/
+static DdNode*
+cuddauxBddSparseComposeRecur(struct common* common, DdNode* f,
+			     struct CuddauxSubst* subst, int nsubst, int deepest)
+{
+  DdManager* dd = common->man->man;
+  DdNode *F,*T,*E;
+  DdNode *res;
+
+  statLine(dd);
+  if (cuddGiveUp(dd)) return(NULL);
+  cuddauxProfileStep(common);
+  F = Cudd_Regular(f);
+
+  /* If we are past the deepest substitution, return f. */
+  if (cuddI(dd,F->index) > deepest) {
+    return(f);
+  }
+
+  /* If problem already solved, look up answer and return. */
+  res = cuddauxCommonLookup1(common,F);
+  if (res != NULL){
+    return(Cudd_NotCond(res,F != f));
+  }
+
+  /* Split and recur on children of this node. */
+  T = cuddauxBddSparseComposeRecur(common,cuddT(F),subst,nsubst,deepest);
+  if (T == NULL) return(NULL);
+  cuddRef(T);
+  E = cuddauxBddSparseComposeRecur(common,cuddE(F),subst,nsubst,deepest);
+  if (E == NULL) {
+    Cudd_IterDerefBdd(dd, T);
+    return(NULL);
+  }
+  cuddRef(E);
+
+  res = cuddBddIteRecur(dd,cuddauxSubstFind(dd,subst,nsubst,F->index),T,E);
+  if (res == NULL) {
+    Cudd_IterDerefBdd(dd, T);
+    Cudd_IterDerefBdd(dd, E);
+    return(NULL);
+  }
+  cuddRef(res);
+  Cudd_IterDerefBdd(dd, T);
+  Cudd_IterDerefBdd(dd, E);
+  cuddDeref(res);
+
+  res = cuddauxCommonInsert1(common,F,res);
+  return(Cudd_NotCond(res,F != f));
+} /* end of cuddauxBddSparseComposeRecur */
+
+/**Function********************************************************************
+
+  Synopsis    [Performs the recursive step of
+  Cuddaux_SparseComposeArrayCommon for ADDs.]
+
+  Description [Same as cuddauxAddVectorComposeRecur, with a sparse
+  substitution.]
+
+  SideEffects [None]
+
+  SeeAlso     [cuddauxAddVectorComposeRecur]
+
+******************************************************************************/
+static DdNode*
+cuddauxAddSparseComposeRecur(struct common* common, DdNode* f,
+			     struct CuddauxSubst* subst, int nsubst, int deepest)
+{
+  DdManager* dd = common->man->man;
+  DdNode *T,*E;
+  DdNode *res;
+
+  cuddauxProfileStep(common);
+  /* If we are past the deepest substitution, return f. */
+  if (cuddI(dd,f->index) > deepest) {
+    return(f);
+  }
+
+  /* Check cache. */
+  res = cuddauxCommonLookup1(common,f);
+  if (res != NULL) return res;
+
+  /* Split and recur on children of this node. */
+  T = cuddauxAddSparseComposeRecur(common,cuddT(f),subst,nsubst,deepest);
+  if (T == NULL)  return(NULL);
+  cuddRef(T);
+  E = cuddauxAddSparseComposeRecur(common,cuddE(f),subst,nsubst,deepest);
+  if (E == NULL) {
+    Cudd_RecursiveDeref(dd, T);
+    return(NULL);
+  }
+  cuddRef(E);
+
+  res = cuddauxAddIteRecur(dd,cuddauxSubstFind(dd,subst,nsubst,f->index),T,E);
+  if (res == NULL) {
+    Cudd_RecursiveDeref(dd, T);
+    Cudd_RecursiveDeref(dd, E);
+    return(NULL);
+  }
+  cuddRef(res);
+  Cudd_RecursiveDeref(dd, T);
+  Cudd_RecursiveDeref(dd, E);
+  cuddDeref(res);
+
+  return cuddauxCommonInsert1(common,f,res);
+} /* end of cuddauxAddSparseComposeRecur */
@@ -17,8 +17,9 @@
 		<li> Cuddaux_ClassifySupport()
 		<li> Cuddaux_IsVarIn()
 		<li> Cuddaux_NodesBelowLevel()
-		<li> cuddaux_list_free()
 		<li> Cuddaux_addGuardOfNode()
+		<li> Cuddaux_addGuardLeafs()
+		<li> Cuddaux_ApplyArray()
 		</ul>
 	    Internal procedures included in this module:
 		<ul>
@@ -29,7 +30,13 @@
 	    Static procedures included in this module:
 		<ul>
 		<li> cuddauxNodesBelowLevelRecur()
-		<li> cuddaux_list_add
+		<li> cuddauxLeavesRecur()
+		<li> cuddauxClearFlag()
+		<li> cuddauxNodesPush()
+		<li> cuddauxAddGuardLeafsAux()
+		<li> cuddauxCollectNodes()
+		<li> cuddauxHeapPush()
+		<li> cuddauxHeapPop()
 		</ul>
 		]
 
@@ -49,11 +56,20 @@
 
 #include "cuddaux.h"
 
-static int cuddaux_list_add(cuddaux_list_t** const plist, DdNode* node);
+static int cuddauxNodesPush(DdNode*** ptab, size_t* psize, size_t* pmaxsize, DdNode* node);
 static int cuddauxNodesBelowLevelRecur(DdManager* manager, DdNode* F, int level,
-				       cuddaux_list_t** plist, st_table* visited,
-				       size_t max, size_t *psize,
-				       bool take_background);
+				       DdNode*** ptab, size_t* psize, size_t* pmaxsize,
+				       size_t max, bool take_background);
+static int cuddauxLeavesRecur(DdManager* manager, DdNode* F,
+			      DdNode*** ptab, size_t* psize, size_t* pmaxsize,
+			      bool take_background);
+static void cuddauxClearFlag(DdNode* F);
+static int cuddauxAddGuardLeafsAux(DdManager* dd, DdNode* f, bool take_background,
+				   DdNode*** pleaves, DdNode*** pguards, size_t* psize);
+static int cuddauxCollectNodes(DdNode* f, st_table* visited,
+			       DdNode*** ptab, size_t* psize, size_t* pmaxsize);
+static void cuddauxHeapPush(DdNode** heap, int* key, int* psize, DdNode* f, int k);
+static DdNode* cuddauxHeapPop(DdNode** heap, int* key, int* psize);
 
 
 /*---------------------------------------------------------------------------*/
@@ -206,10 +222,10 @@ Cuddaux_IsVarIn(DdManager* dd, DdNode* f, DdNode* var)
 
 /**Function********************************************************************
 
-  Synopsis    [List of nodes below some level reachable from a root node.]
+  Synopsis    [Array of nodes below some level reachable from a root node.]
 
-  Description [List of nodes below some level reachable from a root
-  node. if max>0, the list is at most of size max (partial list).
+  Description [Array of nodes below some level reachable from a root
+  node. if max>0, the array is at most of size max (partial array).
 
   Given a BDD/ADD f and a variable level level the function
   performs a depth-first search of the graph rooted at $f$ and select
@@ -218,76 +234,224 @@ Cuddaux_IsVarIn(DdManager* dd, DdNode* f, DdNode* var)
   functions collects only constant nodes. The background node is not
   returned in the result if take_background==0.
 
-  Returns the list of nodes, the index of which has its level equal or below
-  level, and the size of the list in *psize, if successful; NULL
-  otherwise. Nodes in the list are NOT referenced.]
+  Visited nodes are marked with the complement bit of their next
+  field, as in Cudd_DagSize, instead of being stored in a hash
+  table. The common case level==CUDD_MAXINDEX and max==0 (all the
+  leaves) uses a specialized traversal.
+
+  Returns the array of nodes, the index of which has its level equal
+  or below level, allocated with malloc, and its size in *psize, if
+  successful and non empty; NULL otherwise. Nodes in the array are NOT
+  referenced.]
 
   SideEffects [None]
 
   SeeAlso     []
 
 ******************************************************************************/
-cuddaux_list_t*
+DdNode**
 Cuddaux_NodesBelowLevel(DdManager* manager, DdNode* f, int level, size_t max, size_t* psize, bool take_background)
 {
-  cuddaux_list_t* res = 0;
-  st_table* visited;
+  DdNode** tab = NULL;
+  size_t maxsize = 0;
+  DdNode* F = Cudd_Regular(f);
+  int res;
 
-  visited = st_init_table(st_ptrcmp,st_ptrhash);
-  if (visited==NULL) return NULL;
   *psize = 0;
-  cuddauxNodesBelowLevelRecur(manager, Cudd_Regular(f), level, &res, visited, max, psize, take_background);
-  if (res==NULL) *psize=0;
+  if (level==CUDD_MAXINDEX && max==0)
+    res = cuddauxLeavesRecur(manager, F, &tab, psize, &maxsize, take_background);
+  else
+    res = cuddauxNodesBelowLevelRecur(manager, F, level, &tab, psize, &maxsize, max, take_background);
+  cuddauxClearFlag(F);
+  if (res==0 || *psize==0){
+    if (tab!=NULL) free(tab);
+    tab = NULL;
+    *psize = 0;
+  }
   assert (max>0 ? *psize<=max : 1);
-  st_free_table(visited);
-  return(res);
+  return(tab);
 }
 
 /**Function********************************************************************
 
-  Synopsis    [Free a list returned by Cuddaux_NodesBelowLevel.]
+  Synopsis    [Logical guard of a node in an ADD.]
 
-  Description [Free a list returned by Cuddaux_NodesBelowLevel.]
+  Description [Logical guard of a node in an ADD.  h is supposed to be
+  a ADD pointed from the ADD f. Returns a BDD which is the sum of the paths that
+  leads from the root node f to the node h, if successful; NULL
+  otherwise. ]
 
   SideEffects [None]
 
   SeeAlso     []
 
 ******************************************************************************/
-void cuddaux_list_free(cuddaux_list_t* list)
+DdNode* Cuddaux_addGuardOfNode(DdManager* manager, DdNode* f, DdNode* h)
 {
-  cuddaux_list_t* p;
-  while (list!=0){
-    p = list;
-    list = list->next;
-    free(p);
-  }
+  DdNode* res;
+  do {
+    manager->reordered = 0;
+    res = cuddauxAddGuardOfNodeRecur(manager, f, h);
+  } while (manager->reordered == 1);
+  return res;
 }
 
 /**Function********************************************************************
 
-  Synopsis    [Logical guard of a node in an ADD.]
+  Synopsis    [Leaves of an ADD together with their guards.]
 
-  Description [Logical guard of a node in an ADD.  h is supposed to be
-  a ADD pointed from the ADD f. Returns a BDD which is the sum of the paths that
-  leads from the root node f to the node h, if successful; NULL
-  otherwise. ]
+  Description [Computes in a single top-down traversal of the ADD f
+  the guards of all its leaves, i.e., for each leaf the BDD which is
+  the sum of the paths leading from f to it. The guard of a node is
+  the disjunction of the guards of its parents, restricted by the
+  decision variable, so that each node is visited once whatever the
+  number of leaves. The background leaf is skipped if
+  take_background==0.
+
+  Returns 1 if successful, with the leaves (not referenced) in
+  *pleaves, their guards (referenced) in *pguards, and their number in
+  *psize; 0 otherwise. The arrays are allocated with malloc.]
 
   SideEffects [None]
 
-  SeeAlso     []
+  SeeAlso     [Cuddaux_addGuardOfNode Cuddaux_NodesBelowLevel]
 
 ******************************************************************************/
-DdNode* Cuddaux_addGuardOfNode(DdManager* manager, DdNode* f, DdNode* h)
+int Cuddaux_addGuardLeafs(DdManager* dd, DdNode* f, bool take_background,
+			  DdNode*** pleaves, DdNode*** pguards, size_t* psize)
 {
-  DdNode* res;
+  int res;
   do {
-    manager->reordered = 0;
-    res = cuddauxAddGuardOfNodeRecur(manager, f, h);
-  } while (manager->reordered == 1);
+    dd->reordered = 0;
+    res = cuddauxAddGuardLeafsAux(dd, f, take_background, pleaves, pguards, psize);
+  } while (dd->reordered == 1);
   return res;
 }
 
+/**Function********************************************************************
+
+  Synopsis    [Combines an array of BDDs or ADDs with an associative and
+  commutative operation.]
+
+  Description [Combines the size nodes of tab with the operation op,
+  by always combining the two smallest operands (in number of nodes)
+  of a work list, which is a priority queue keyed on their size. This
+  keeps intermediate results small when the operands have very
+  different sizes, compared to a left-to-right fold.
+
+  If simplify is true and op is CUDDAUX_BDD_AND (resp. CUDDAUX_BDD_OR),
+  the larger operand f of each step is first simplified with
+  Cudd_bddRestrict by the smaller one g (resp. its negation), which
+  does not change the result of the step. simplify is ignored for
+  ADDs. The computation stops as soon as an intermediate result is
+  absorbing (false for AND, true for OR, 0 for TIMES).
+
+  Returns the result (not referenced) if successful and size>0, with
+  in *ppeak the size of the largest operand or intermediate result;
+  NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cudd_bddAnd Cudd_bddOr Cudd_addApply]
+
+******************************************************************************/
+DdNode*
+Cuddaux_ApplyArray(DdManager* dd, enum cuddaux_nary op, bool simplify,
+		   DdNode** tab, int size, int* ppeak)
+{
+  DdNode **heap;
+  int *key;
+  DdNode *absorbing, *f, *g, *h, *res;
+  int i, nb, k, peak;
+  bool bdd = op==CUDDAUX_BDD_AND || op==CUDDAUX_BDD_OR;
+
+  *ppeak = 0;
+  if (size<=0) return NULL;
+  absorbing =
+    op==CUDDAUX_BDD_AND ? Cudd_Not(DD_ONE(dd)) :
+    op==CUDDAUX_BDD_OR ? DD_ONE(dd) :
+    op==CUDDAUX_ADD_TIMES ? DD_ZERO(dd) :
+    NULL;
+  heap = (DdNode**)malloc(size*sizeof(DdNode*));
+  key = (int*)malloc(size*sizeof(int));
+  if (heap==NULL || key==NULL){
+    if (heap!=NULL) free(heap);
+    if (key!=NULL) free(key);
+    dd->errorCode = CUDD_MEMORY_OUT;
+    return NULL;
+  }
+  res = NULL;
+  nb = 0;
+  peak = 0;
+  for (i=0; i<size; i++){
+    f = tab[i];
+    cuddRef(f);
+    if (f==absorbing){
+      res = f;
+      break;
+    }
+    k = Cudd_DagSize(f);
+    if (k>peak) peak = k;
+    cuddauxHeapPush(heap,key,&nb,f,k);
+  }
+  while (res==NULL && nb>1){
+    g = cuddauxHeapPop(heap,key,&nb);
+    f = cuddauxHeapPop(heap,key,&nb);
+    if (simplify && bdd){
+      h = Cudd_bddRestrict(dd,f, op==CUDDAUX_BDD_AND ? g : Cudd_Not(g));
+      if (h==NULL) goto cuddauxApplyArray_error;
+      cuddRef(h);
+      Cudd_RecursiveDeref(dd,f);
+      f = h;
+    }
+    switch (op){
+    case CUDDAUX_BDD_AND:
+      h = Cudd_bddAnd(dd,f,g);
+      break;
+    case CUDDAUX_BDD_OR:
+      h = Cudd_bddOr(dd,f,g);
+      break;
+    case CUDDAUX_ADD_PLUS:
+      h = Cudd_addApply(dd,Cudd_addPlus,f,g);
+      break;
+    case CUDDAUX_ADD_TIMES:
+      h = Cudd_addApply(dd,Cudd_addTimes,f,g);
+      break;
+    default:
+      h = NULL;
+    }
+    if (h==NULL) goto cuddauxApplyArray_error;
+    cuddRef(h);
+    Cudd_RecursiveDeref(dd,f);
+    Cudd_RecursiveDeref(dd,g);
+    if (h==absorbing){
+      res = h;
+      break;
+    }
+    k = Cudd_DagSize(h);
+    if (k>peak) peak = k;
+    cuddauxHeapPush(heap,key,&nb,h,k);
+  }
+  if (res==NULL)
+    res = cuddauxHeapPop(heap,key,&nb);
+  for (i=0; i<nb; i++)
+    Cudd_RecursiveDeref(dd,heap[i]);
+  free(heap);
+  free(key);
+  cuddDeref(res);
+  *ppeak = peak;
+  return res;
+
+ cuddauxApplyArray_error:
+  Cudd_RecursiveDeref(dd,f);
+  Cudd_RecursiveDeref(dd,g);
+  for (i=0; i<nb; i++)
+    Cudd_RecursiveDeref(dd,heap[i]);
+  free(heap);
+  free(key);
+  return NULL;
+}
+
 /*---------------------------------------------------------------------------*/
 /* Definition of internal functions                                          */
 /*---------------------------------------------------------------------------*/
@@ -488,53 +652,269 @@ cuddauxAddGuardOfNodeRecur(DdManager* manager, DdNode* f, DdNode* h)
 
   Description [Performs the recursive step of
   Cuddaux_NodesBelowLevelRecur.  F is supposed to be a regular
-  node. Returns 1 if successful, NULL otherwise.
-  The background node is not put in the list if take_background==0 ]
+  node. Returns 1 if successful, 0 otherwise.
+  The background node is not put in the array if take_background==0.
+  Visited nodes are marked and should be unmarked with
+  cuddauxClearFlag.]
 
   SideEffects [None]
 
-  SeeAlso     []
+  SeeAlso     [cuddauxLeavesRecur cuddauxClearFlag]
 
 ******************************************************************************/
 static int
 cuddauxNodesBelowLevelRecur(DdManager* manager, DdNode* F, int level,
-			    cuddaux_list_t** plist, st_table* visited,
-			    size_t max, size_t* psize,
-			    bool take_background)
+			    DdNode*** ptab, size_t* psize, size_t* pmaxsize,
+			    size_t max, bool take_background)
 {
   int topF,res;
 
-  if ((!take_background && F==DD_BACKGROUND(manager)) || st_is_member(visited, (char *) F) == 1){
+  if (Cudd_IsComplement(F->next)){
+    return 1;
+  }
+  F->next = Cudd_Not(F->next);
+  if (!take_background && F==DD_BACKGROUND(manager)){
     return 1;
   }
   topF = cuddI(manager,F->index);
   if (topF < level){
-    res = cuddauxNodesBelowLevelRecur(manager, Cudd_Regular(cuddT(F)), level, plist, visited, max, psize, take_background);
+    res = cuddauxNodesBelowLevelRecur(manager, cuddT(F), level, ptab, psize, pmaxsize, max, take_background);
     if (res==0) return 0;
     if (max == 0 || *psize<max){
-      res = cuddauxNodesBelowLevelRecur(manager, Cudd_Regular(cuddE(F)), level, plist, visited, max, psize, take_background);
+      res = cuddauxNodesBelowLevelRecur(manager, Cudd_Regular(cuddE(F)), level, ptab, psize, pmaxsize, max, take_background);
       if (res==0) return 0;
     }
   }
   else {
-    res = cuddaux_list_add(plist,F);
-    (*psize)++;
+    res = cuddauxNodesPush(ptab,psize,pmaxsize,F);
     if (res==0) return 0;
   }
-  if (st_add_direct(visited, (char *) F, NULL) == ST_OUT_OF_MEM){
-    cuddaux_list_free(*plist);
-    return 0;
+  return 1;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Collects the leaves of a diagram.]
+
+  Description [Specialization of cuddauxNodesBelowLevelRecur to
+  level==CUDD_MAXINDEX and max==0. Each leaf is collected once. F is
+  supposed to be a regular node. Returns 1 if successful, 0
+  otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [cuddauxNodesBelowLevelRecur cuddauxClearFlag]
+
+******************************************************************************/
+static int
+cuddauxLeavesRecur(DdManager* manager, DdNode* F,
+		   DdNode*** ptab, size_t* psize, size_t* pmaxsize,
+		   bool take_background)
+{
+  if (Cudd_IsComplement(F->next)){
+    return 1;
+  }
+  F->next = Cudd_Not(F->next);
+  if (cuddIsConstant(F)){
+    if (take_background || F!=DD_BACKGROUND(manager))
+      return cuddauxNodesPush(ptab,psize,pmaxsize,F);
+    else
+      return 1;
+  }
+  return
+    cuddauxLeavesRecur(manager, cuddT(F), ptab, psize, pmaxsize, take_background) &&
+    cuddauxLeavesRecur(manager, Cudd_Regular(cuddE(F)), ptab, psize, pmaxsize, take_background);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Unmarks the nodes visited by cuddauxNodesBelowLevelRecur.]
+
+  Description [Same as ddClearFlag in cuddUtil.c. Each marked node is
+  reachable from F through marked nodes, so that the traversal stops
+  at unmarked nodes.]
+
+  SideEffects [None]
+
+  SeeAlso     [cuddauxNodesBelowLevelRecur]
+
+******************************************************************************/
+static void
+cuddauxClearFlag(DdNode* F)
+{
+  if (!Cudd_IsComplement(F->next)){
+    return;
+  }
+  F->next = Cudd_Regular(F->next);
+  if (cuddIsConstant(F)){
+    return;
+  }
+  cuddauxClearFlag(cuddT(F));
+  cuddauxClearFlag(Cudd_Regular(cuddE(F)));
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Add a node to a growable array of nodes.]
+
+  Description [Add a node to the array *ptab of size *psize and
+  capacity *pmaxsize, which is reallocated if needed. Returns 1 if
+  successful, 0 otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     []
+
+******************************************************************************/
+static int
+cuddauxNodesPush(DdNode*** ptab, size_t* psize, size_t* pmaxsize, DdNode* node)
+{
+  if (*psize==*pmaxsize){
+    size_t maxsize = *pmaxsize==0 ? 16 : 2*(*pmaxsize);
+    DdNode** tab = (DdNode**)realloc(*ptab,maxsize*sizeof(DdNode*));
+    if (tab==NULL) return 0;
+    *ptab = tab;
+    *pmaxsize = maxsize;
   }
+  (*ptab)[(*psize)++] = node;
   return 1;
 }
 
 /**Function********************************************************************
 
-  Synopsis    [Add a node to a list of nodes.]
+  Synopsis    [Performs one attempt of Cuddaux_addGuardLeafs.]
 
-  Description [Add a node to a list of nodes. plist is the pointer to
-  the list, and is an input/output parameter. Returns 1 if successful,
-  0 otherwise.]
+  Description [The nodes of f are sorted by increasing level, so that
+  the guard of a node is complete when the node is reached. Returns 0
+  on failure or if a reordering occured.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_addGuardLeafs]
+
+******************************************************************************/
+static int
+cuddauxAddGuardLeafsAux(DdManager* dd, DdNode* f, bool take_background,
+			DdNode*** pleaves, DdNode*** pguards, size_t* psize)
+{
+  st_table* visited;
+  DdNode **tab, **sorted, **guard, **leaves, **guards;
+  DdNode *N, *var, *g, *child, *gchild, *old, *tmp;
+  size_t *count;
+  size_t i,k,size,maxsize,nleaves;
+  char* pos;
+  int level,nvars,j;
+  int res = 0;
+
+  visited = st_init_table(st_ptrcmp,st_ptrhash);
+  if (visited==NULL) return 0;
+  tab = sorted = guard = leaves = guards = NULL;
+  count = NULL;
+  size = maxsize = nleaves = 0;
+  nvars = dd->size;
+
+  /* 1. Collect the nodes and sort them by increasing level */
+  if (!cuddauxCollectNodes(f,visited,&tab,&size,&maxsize))
+    goto cuddauxAddGuardLeafs_end;
+  count = (size_t*)calloc(nvars+2,sizeof(size_t));
+  sorted = (DdNode**)malloc(size*sizeof(DdNode*));
+  guard = (DdNode**)calloc(size,sizeof(DdNode*));
+  leaves = (DdNode**)malloc(size*sizeof(DdNode*));
+  guards = (DdNode**)malloc(size*sizeof(DdNode*));
+  if (count==NULL || sorted==NULL || guard==NULL || leaves==NULL || guards==NULL)
+    goto cuddauxAddGuardLeafs_end;
+  for (i=0; i<size; i++){
+    level = cuddIsConstant(tab[i]) ? nvars : cuddI(dd,tab[i]->index);
+    count[level+1]++;
+  }
+  for (level=1; level<=nvars+1; level++)
+    count[level] += count[level-1];
+  for (i=0; i<size; i++){
+    level = cuddIsConstant(tab[i]) ? nvars : cuddI(dd,tab[i]->index);
+    sorted[count[level]++] = tab[i];
+  }
+  for (i=0; i<size; i++){
+    if (st_insert(visited,(char*)sorted[i],(char*)(uintptr_t)i)==ST_OUT_OF_MEM)
+      goto cuddauxAddGuardLeafs_end;
+  }
+  /* 2. Propagate the guards top-down */
+  assert(sorted[0]==f);
+  guard[0] = DD_ONE(dd);
+  cuddRef(guard[0]);
+  for (i=0; i<size; i++){
+    N = sorted[i];
+    g = guard[i];
+    assert(g!=NULL);
+    if (cuddIsConstant(N)){
+      if (!take_background && N==DD_BACKGROUND(dd)){
+	Cudd_IterDerefBdd(dd,g);
+      }
+      else {
+	leaves[nleaves] = N;
+	guards[nleaves] = g;
+	nleaves++;
+      }
+      guard[i] = NULL;
+      continue;
+    }
+    var = dd->vars[N->index];
+    for (j=0; j<2; j++){
+      child = j==0 ? cuddT(N) : cuddE(N);
+      gchild = cuddBddAndRecur(dd,g,j==0 ? var : Cudd_Not(var));
+      if (gchild==NULL)
+	goto cuddauxAddGuardLeafs_end;
+      cuddRef(gchild);
+      st_lookup(visited,(char*)child,&pos);
+      k = (size_t)(uintptr_t)pos;
+      old = guard[k];
+      if (old!=NULL){
+	tmp = cuddBddAndRecur(dd,Cudd_Not(old),Cudd_Not(gchild));
+	if (tmp==NULL){
+	  Cudd_IterDerefBdd(dd,gchild);
+	  goto cuddauxAddGuardLeafs_end;
+	}
+	tmp = Cudd_Not(tmp);
+	cuddRef(tmp);
+	Cudd_IterDerefBdd(dd,old);
+	Cudd_IterDerefBdd(dd,gchild);
+	gchild = tmp;
+      }
+      guard[k] = gchild;
+    }
+    Cudd_IterDerefBdd(dd,g);
+    guard[i] = NULL;
+  }
+  res = 1;
+ cuddauxAddGuardLeafs_end:
+  if (res){
+    *pleaves = leaves;
+    *pguards = guards;
+    *psize = nleaves;
+  }
+  else {
+    if (guard!=NULL){
+      for (i=0; i<size; i++)
+	if (guard[i]!=NULL) Cudd_IterDerefBdd(dd,guard[i]);
+    }
+    for (i=0; i<nleaves; i++)
+      Cudd_IterDerefBdd(dd,guards[i]);
+    if (leaves!=NULL) free(leaves);
+    if (guards!=NULL) free(guards);
+  }
+  if (guard!=NULL) free(guard);
+  if (sorted!=NULL) free(sorted);
+  if (count!=NULL) free(count);
+  if (tab!=NULL) free(tab);
+  st_free_table(visited);
+  return res;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Collects the nodes of an ADD not yet visited.]
+
+  Description [Adds the nodes of f not in visited to the array *ptab.
+  Returns 1 if successful; 0 otherwise.]
 
   SideEffects [None]
 
@@ -542,12 +922,79 @@ cuddauxNodesBelowLevelRecur(DdManager* manager, DdNode* F, int level,
 
 ******************************************************************************/
 static int
-cuddaux_list_add(cuddaux_list_t** const plist, DdNode* node)
+cuddauxCollectNodes(DdNode* f, st_table* visited,
+		    DdNode*** ptab, size_t* psize, size_t* pmaxsize)
 {
-  cuddaux_list_t* nlist = (cuddaux_list_t*)malloc(sizeof(cuddaux_list_t));
-  if (nlist==NULL) return(0);
-  nlist->node = node;
-  nlist->next = *plist;
-  *plist = nlist;
+  if (st_is_member(visited,(char*)f))
+    return 1;
+  if (st_add_direct(visited,(char*)f,NULL)==ST_OUT_OF_MEM)
+    return 0;
+  if (!cuddauxNodesPush(ptab,psize,pmaxsize,f))
+    return 0;
+  if (!cuddIsConstant(f)){
+    if (!cuddauxCollectNodes(cuddT(f),visited,ptab,psize,pmaxsize) ||
+	!cuddauxCollectNodes(cuddE(f),visited,ptab,psize,pmaxsize))
+      return 0;
+  }
   return 1;
 }
+
+/**Function********************************************************************
+
+  Synopsis    [Inserts a node in the work list of Cuddaux_ApplyArray.]
+
+  Description [The work list is a binary min-heap of size *psize,
+  where key[i] is the size of heap[i].]
+
+  SideEffects [None]
+
+  SeeAlso     [cuddauxHeapPop]
+
+******************************************************************************/
+static void
+cuddauxHeapPush(DdNode** heap, int* key, int* psize, DdNode* f, int k)
+{
+  int i = (*psize)++;
+  while (i>0 && key[(i-1)/2]>k){
+    heap[i] = heap[(i-1)/2];
+    key[i] = key[(i-1)/2];
+    i = (i-1)/2;
+  }
+  heap[i] = f;
+  key[i] = k;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Removes the smallest node of the work list of
+  Cuddaux_ApplyArray.]
+
+  Description [Returns the node of smallest key; *psize should be
+  positive.]
+
+  SideEffects [None]
+
+  SeeAlso     [cuddauxHeapPush]
+
+******************************************************************************/
+static DdNode*
+cuddauxHeapPop(DdNode** heap, int* key, int* psize)
+{
+  DdNode* res = heap[0];
+  int size = --(*psize);
+  DdNode* f = heap[size];
+  int k = key[size];
+  int i = 0;
+  int j;
+
+  while ((j=2*i+1)<size){
+    if (j+1<size && key[j+1]<key[j]) j++;
+    if (key[j]>=k) break;
+    heap[i] = heap[j];
+    key[i] = key[j];
+    i = j;
+  }
+  heap[i] = f;
+  key[i] = k;
+  return res;
+}
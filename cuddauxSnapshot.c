@@ -0,0 +1,492 @@
+/**CFile***********************************************************************
+
+  FileName    [cuddauxSnapshot.c]
+
+  PackageName [cuddaux]
+
+  Synopsis    [Read-only snapshots of BDD/ADD forests.]
+
+  Description [A snapshot is a file containing a flat array of nodes,
+	       sorted by decreasing level, that can be mapped in memory
+	       and queried without a DdManager. Nodes are created in a
+	       manager only when a root is converted back into a
+	       diagram. Several processes mapping the same file share
+	       it through the page cache.
+
+	       Layout of the file (native endianness):
+	       <ul>
+	       <li> the header (struct CuddauxSnapshotHeader);
+	       <li> int32 invperm[nvars]: index of the variable at each level;
+	       <li> int32 perm[nvars]: level of each variable;
+	       <li> uint64 roots[nroots]: edges to the roots;
+	       <li> struct CuddauxSnapshotNode nodes[nnodes].
+	       </ul>
+	       An edge is (position of the node << 1) | complement. The
+	       constant nodes come first, so that for BDDs the edge 0 is
+	       true and the edge 1 is false.
+
+	    External procedures included in this module:
+		<ul>
+		<li> Cuddaux_SnapshotWrite()
+		<li> Cuddaux_SnapshotOpen()
+		<li> Cuddaux_SnapshotClose()
+		<li> Cuddaux_SnapshotEval()
+		<li> Cuddaux_SnapshotToDd()
+		</ul>
+	    Static procedures included in this module:
+		<ul>
+		<li> cuddauxSnapshotCollect()
+		<li> cuddauxSnapshotCheck()
+		<li> cuddauxSnapshotToDdRecur()
+		</ul>
+		]
+
+  Author      [Bertrand Jeannet]
+
+  Copyright   []
+
+******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cuddInt.h"
+#include "util.h"
+#include "st.h"
+
+#include "cuddaux.h"
+
+/**AutomaticStart*************************************************************/
+
+/*---------------------------------------------------------------------------*/
+/* Static function prototypes                                                */
+/*---------------------------------------------------------------------------*/
+static int cuddauxSnapshotCollect(DdNode* f, st_table* visited, DdNode*** ptab, size_t* psize, size_t* pmaxsize);
+static int cuddauxSnapshotCheck(const struct CuddauxSnapshot* snap);
+static DdNode* cuddauxSnapshotToDdRecur(DdManager* dd, const struct CuddauxSnapshot* snap, uint64_t pos, st_table* memo);
+
+/**AutomaticEnd***************************************************************/
+
+/*---------------------------------------------------------------------------*/
+/* Definition of exported functions                                          */
+/*---------------------------------------------------------------------------*/
+
+/**Function********************************************************************
+
+  Synopsis    [Writes a snapshot of an array of BDDs or ADDs.]
+
+  Description [Writes in the file the snapshot of the nroots diagrams
+  of roots, which are BDDs if add is false, ADDs with double leaves
+  otherwise. The variable order of the manager is recorded in the
+  header. Returns 1 if successful; 0 otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_SnapshotOpen]
+
+******************************************************************************/
+int
+Cuddaux_SnapshotWrite(DdManager* dd,
+		      bool add,
+		      DdNode** roots,
+		      int nroots,
+		      const char* filename)
+{
+  struct CuddauxSnapshotHeader header;
+  struct CuddauxSnapshotNode node;
+  st_table* visited;
+  DdNode** tab;
+  DdNode** sorted;
+  size_t* count;
+  size_t i,size,maxsize;
+  int nvars,level;
+  char* pos;
+  FILE* file;
+  int res = 0;
+
+  visited = st_init_table(st_ptrcmp,st_ptrhash);
+  if (visited==NULL) return 0;
+  tab = NULL; sorted = NULL; count = NULL; file = NULL;
+  size = maxsize = 0;
+  nvars = Cudd_ReadSize(dd);
+
+  /* 1. Collect the nodes */
+  for (i=0; i<(size_t)nroots; i++){
+    if (!cuddauxSnapshotCollect(Cudd_Regular(roots[i]),visited,&tab,&size,&maxsize))
+      goto cuddauxSnapshotWrite_end;
+  }
+  /* 2. Sort them by decreasing level, constants first (bucket sort) */
+  count = (size_t*)calloc(nvars+2,sizeof(size_t));
+  sorted = (DdNode**)malloc(size*sizeof(DdNode*));
+  if (count==NULL || (size>0 && sorted==NULL))
+    goto cuddauxSnapshotWrite_end;
+  for (i=0; i<size; i++){
+    level = cuddIsConstant(tab[i]) ? nvars : cuddI(dd,tab[i]->index);
+    count[nvars-level+1]++;
+  }
+  for (level=1; level<=nvars+1; level++)
+    count[level] += count[level-1];
+  for (i=0; i<size; i++){
+    level = cuddIsConstant(tab[i]) ? nvars : cuddI(dd,tab[i]->index);
+    sorted[count[nvars-level]++] = tab[i];
+  }
+  for (i=0; i<size; i++){
+    pos = (char*)(uintptr_t)i;
+    if (st_insert(visited,(char*)sorted[i],pos)==ST_OUT_OF_MEM)
+      goto cuddauxSnapshotWrite_end;
+  }
+  /* 3. Write the file */
+  file = fopen(filename,"wb");
+  if (file==NULL)
+    goto cuddauxSnapshotWrite_end;
+  memset(&header,0,sizeof(header));
+  memcpy(header.magic,CUDDAUX_SNAPSHOT_MAGIC,8);
+  header.version = CUDDAUX_SNAPSHOT_VERSION;
+  header.add = add;
+  header.nvars = nvars;
+  header.nroots = nroots;
+  header.nnodes = size;
+  if (fwrite(&header,sizeof(header),1,file)!=1)
+    goto cuddauxSnapshotWrite_end;
+  for (level=0; level<nvars; level++){
+    int32_t index = Cudd_ReadInvPerm(dd,level);
+    if (fwrite(&index,sizeof(int32_t),1,file)!=1)
+      goto cuddauxSnapshotWrite_end;
+  }
+  for (i=0; i<(size_t)nvars; i++){
+    int32_t perm = Cudd_ReadPerm(dd,i);
+    if (fwrite(&perm,sizeof(int32_t),1,file)!=1)
+      goto cuddauxSnapshotWrite_end;
+  }
+  for (i=0; i<(size_t)nroots; i++){
+    uint64_t edge;
+    st_lookup(visited,(char*)Cudd_Regular(roots[i]),&pos);
+    edge = ((uint64_t)(uintptr_t)pos << 1) | Cudd_IsComplement(roots[i]);
+    if (fwrite(&edge,sizeof(uint64_t),1,file)!=1)
+      goto cuddauxSnapshotWrite_end;
+  }
+  for (i=0; i<size; i++){
+    DdNode* N = sorted[i];
+    memset(&node,0,sizeof(node));
+    if (cuddIsConstant(N)){
+      node.index = CUDD_CONST_INDEX;
+      node.type.dbl = cuddV(N);
+    }
+    else {
+      DdNode* T = cuddT(N);
+      DdNode* E = cuddE(N);
+      node.index = N->index;
+      st_lookup(visited,(char*)Cudd_Regular(T),&pos);
+      node.type.kids.T = ((uint64_t)(uintptr_t)pos << 1) | Cudd_IsComplement(T);
+      st_lookup(visited,(char*)Cudd_Regular(E),&pos);
+      node.type.kids.E = ((uint64_t)(uintptr_t)pos << 1) | Cudd_IsComplement(E);
+    }
+    if (fwrite(&node,sizeof(node),1,file)!=1)
+      goto cuddauxSnapshotWrite_end;
+  }
+  res = 1;
+ cuddauxSnapshotWrite_end:
+  if (file!=NULL && fclose(file)!=0) res = 0;
+  if (count!=NULL) free(count);
+  if (sorted!=NULL) free(sorted);
+  if (tab!=NULL) free(tab);
+  st_free_table(visited);
+  return res;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Maps a snapshot in memory.]
+
+  Description [Maps the file written by Cuddaux_SnapshotWrite() in
+  memory, read-only, and checks its header and its edges. Returns a
+  pointer to the snapshot if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_SnapshotClose]
+
+******************************************************************************/
+struct CuddauxSnapshot*
+Cuddaux_SnapshotOpen(const char* filename)
+{
+  struct CuddauxSnapshot* snap;
+  const struct CuddauxSnapshotHeader* header;
+  struct stat st;
+  size_t size;
+  void* base;
+  int fd;
+
+  fd = open(filename,O_RDONLY);
+  if (fd<0) return NULL;
+  if (fstat(fd,&st)!=0 || (size_t)st.st_size<sizeof(struct CuddauxSnapshotHeader)){
+    close(fd);
+    return NULL;
+  }
+  size = st.st_size;
+  base = mmap(NULL,size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if (base==MAP_FAILED) return NULL;
+  header = (const struct CuddauxSnapshotHeader*)base;
+  if (memcmp(header->magic,CUDDAUX_SNAPSHOT_MAGIC,8)!=0 ||
+      header->version!=CUDDAUX_SNAPSHOT_VERSION ||
+      header->nnodes > size/sizeof(struct CuddauxSnapshotNode) ||
+      size != (sizeof(struct CuddauxSnapshotHeader) +
+	       2*(size_t)header->nvars*sizeof(int32_t) +
+	       (size_t)header->nroots*sizeof(uint64_t) +
+	       header->nnodes*sizeof(struct CuddauxSnapshotNode))){
+    munmap(base,size);
+    return NULL;
+  }
+  snap = (struct CuddauxSnapshot*)malloc(sizeof(struct CuddauxSnapshot));
+  if (snap==NULL){
+    munmap(base,size);
+    return NULL;
+  }
+  snap->base = base;
+  snap->size = size;
+  snap->header = header;
+  snap->invperm = (const int32_t*)(header+1);
+  snap->perm = snap->invperm + header->nvars;
+  snap->roots = (const uint64_t*)(snap->perm + header->nvars);
+  snap->nodes = (const struct CuddauxSnapshotNode*)(snap->roots + header->nroots);
+  if (!cuddauxSnapshotCheck(snap)){
+    Cuddaux_SnapshotClose(snap);
+    return NULL;
+  }
+  return snap;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Unmaps a snapshot.]
+
+  SideEffects [None]
+
+  SeeAlso     [Cuddaux_SnapshotOpen]
+
+******************************************************************************/
+void
+Cuddaux_SnapshotClose(struct CuddauxSnapshot* snap)
+{
+  munmap(snap->base,snap->size);
+  free(snap);
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Evaluates a diagram of a snapshot.]
+
+  Description [Follows the edge according to the values of the
+  variables given by inputs (indexed by variable indices; variables
+  beyond ninputs are false). Returns the edge to the reached constant
+  node, complemented if the path has an odd number of complemented
+  edges.]
+
+  SideEffects [None]
+
+  SeeAlso     []
+
+******************************************************************************/
+uint64_t
+Cuddaux_SnapshotEval(const struct CuddauxSnapshot* snap,
+		     uint64_t edge,
+		     const int* inputs,
+		     int ninputs)
+{
+  uint64_t compl = edge & 1;
+  const struct CuddauxSnapshotNode* N = &snap->nodes[edge >> 1];
+
+  while (N->index!=CUDD_CONST_INDEX){
+    edge = ((int)N->index<ninputs && inputs[N->index]) ? N->type.kids.T : N->type.kids.E;
+    compl ^= edge & 1;
+    N = &snap->nodes[edge >> 1];
+  }
+  return (edge & ~(uint64_t)1) | compl;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Converts a diagram of a snapshot into a BDD or an ADD.]
+
+  Description [Builds in the manager the diagram pointed to by edge,
+  which is a BDD or an ADD depending on the snapshot. The variable
+  order of the manager may differ from the one of the snapshot.
+  Returns a pointer to the result if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     []
+
+******************************************************************************/
+DdNode*
+Cuddaux_SnapshotToDd(DdManager* dd,
+		     const struct CuddauxSnapshot* snap,
+		     uint64_t edge)
+{
+  st_table* memo;
+  st_generator* gen;
+  char *key,*value;
+  DdNode* res;
+
+  /* Memoized on the positions of the nodes reached from edge only */
+  memo = st_init_table(st_numcmp,st_numhash);
+  if (memo==NULL) return NULL;
+  res = cuddauxSnapshotToDdRecur(dd,snap,edge >> 1,memo);
+  if (res!=NULL){
+    if (edge & 1) res = Cudd_Not(res);
+    cuddRef(res);
+  }
+  st_foreach_item(memo,gen,&key,&value){
+    Cudd_RecursiveDeref(dd,(DdNode*)value);
+  }
+  st_free_table(memo);
+  if (res!=NULL) cuddDeref(res);
+  return res;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Definition of static functions                                            */
+/*---------------------------------------------------------------------------*/
+
+/**Function********************************************************************
+
+  Synopsis    [Collects the regular nodes of f not yet visited.]
+
+  Description [Adds the nodes of f not in visited to the table *ptab,
+  which is reallocated if needed. Returns 1 if successful; 0
+  otherwise.]
+
+  SideEffects [None]
+
+******************************************************************************/
+static int
+cuddauxSnapshotCollect(DdNode* f,
+		       st_table* visited,
+		       DdNode*** ptab, size_t* psize, size_t* pmaxsize)
+{
+  int res;
+
+  assert(!Cudd_IsComplement(f));
+  if (st_is_member(visited,(char*)f))
+    return 1;
+  res = st_add_direct(visited,(char*)f,NULL);
+  if (res==ST_OUT_OF_MEM) return 0;
+  if (*psize==*pmaxsize){
+    size_t maxsize = *pmaxsize==0 ? 1024 : 2*(*pmaxsize);
+    DdNode** tab = (DdNode**)realloc(*ptab,maxsize*sizeof(DdNode*));
+    if (tab==NULL) return 0;
+    *ptab = tab;
+    *pmaxsize = maxsize;
+  }
+  (*ptab)[(*psize)++] = f;
+  if (!cuddIsConstant(f)){
+    DdNode* T = Cudd_Regular(cuddT(f));
+    DdNode* E = Cudd_Regular(cuddE(f));
+    if (!cuddauxSnapshotCollect(T,visited,ptab,psize,pmaxsize))
+      return 0;
+    if (!cuddauxSnapshotCollect(E,visited,ptab,psize,pmaxsize))
+      return 0;
+  }
+  return 1;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Checks the roots and the nodes of a snapshot.]
+
+  Description [Nodes are sorted by decreasing level: the children of a
+  node precede it, which rules out cycles, and variable indices are
+  those of the manager. Returns 1 if the positions of the roots and
+  children and the variable indices are valid; 0 otherwise.]
+
+  SideEffects [None]
+
+******************************************************************************/
+static int
+cuddauxSnapshotCheck(const struct CuddauxSnapshot* snap)
+{
+  const struct CuddauxSnapshotNode* N;
+  uint64_t i;
+
+  for (i=0; i<snap->header->nroots; i++){
+    if ((snap->roots[i] >> 1) >= snap->header->nnodes) return 0;
+  }
+  for (i=0; i<snap->header->nnodes; i++){
+    N = &snap->nodes[i];
+    if (N->index!=CUDD_CONST_INDEX &&
+	(N->index >= snap->header->nvars ||
+	 (N->type.kids.T >> 1) >= i ||
+	 (N->type.kids.E >> 1) >= i))
+      return 0;
+  }
+  return 1;
+}
+
+/**Function********************************************************************
+
+  Synopsis    [Performs the recursive step of Cuddaux_SnapshotToDd.]
+
+  Description [Returns the diagram of the node at position pos,
+  memoized and referenced in memo, indexed by positions.]
+
+  SideEffects [None]
+
+******************************************************************************/
+static DdNode*
+cuddauxSnapshotToDdRecur(DdManager* dd,
+			 const struct CuddauxSnapshot* snap,
+			 uint64_t pos,
+			 st_table* memo)
+{
+  const struct CuddauxSnapshotNode* N;
+  DdNode *T,*E,*var,*res;
+  char* value;
+
+  if (st_lookup(memo,(char*)(uintptr_t)pos,&value))
+    return (DdNode*)value;
+
+  N = &snap->nodes[pos];
+  if (N->index==CUDD_CONST_INDEX){
+    res = snap->header->add ? Cudd_addConst(dd,N->type.dbl) : DD_ONE(dd);
+  }
+  else {
+    T = cuddauxSnapshotToDdRecur(dd,snap,N->type.kids.T >> 1,memo);
+    if (T==NULL) return NULL;
+    E = cuddauxSnapshotToDdRecur(dd,snap,N->type.kids.E >> 1,memo);
+    if (E==NULL) return NULL;
+    if (N->type.kids.T & 1) T = Cudd_Not(T);
+    if (N->type.kids.E & 1) E = Cudd_Not(E);
+    if (snap->header->add){
+      var = Cudd_addIthVar(dd,N->index);
+      if (var==NULL) return NULL;
+      cuddRef(var);
+      res = Cudd_addIte(dd,var,T,E);
+      if (res==NULL){
+	Cudd_RecursiveDeref(dd,var);
+	return NULL;
+      }
+      cuddRef(res);
+      Cudd_RecursiveDeref(dd,var);
+      cuddDeref(res);
+    }
+    else {
+      var = Cudd_bddIthVar(dd,N->index);
+      if (var==NULL) return NULL;
+      res = Cudd_bddIte(dd,var,T,E);
+    }
+  }
+  if (res==NULL) return NULL;
+  cuddRef(res);
+  if (st_insert(memo,(char*)(uintptr_t)pos,(char*)res)==ST_OUT_OF_MEM){
+    Cudd_RecursiveDeref(dd,res);
+    dd->errorCode = CUDD_MEMORY_OUT;
+    return NULL;
+  }
+  return res;
+}
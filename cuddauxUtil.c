@@ -22,23 +22,76 @@
 #include "util.h"
 #include "st.h"
 #include "cuddaux.h"
+#include "caml/memory.h"
 
 /* ********************************************************************** */
 /* CuddauxMan */
 /* ********************************************************************** */
 
+/* Releases the manager, once it is only held by pending dereferences */
+static void cuddauxManQuit(struct CuddauxMan* man)
+{
+  size_t i;
+
+  for (i=0; i<man->npending; i++)
+    Cudd_RecursiveDeref(man->man,man->pending[i]);
+  assert(Cudd_CheckZeroRef(man->man)==0);
+  Cudd_Quit(man->man);
+  caml_remove_generational_global_root(&man->gc_fun);
+  caml_remove_generational_global_root(&man->reordering_fun);
+  caml_remove_generational_global_root(&man->event_fun);
+  if (man->pending!=NULL) free(man->pending);
+  free(man);
+}
+
 void cuddauxManFree(struct CuddauxMan* man)
 {
   assert(man->count>=1);
-  if (man->count<=1){
-    assert(Cudd_CheckZeroRef(man->man)==0);
-    Cudd_Quit(man->man);
-    free(man);
-  }
+  assert(man->count>man->npending);
+  if (man->count<=man->npending+1)
+    cuddauxManQuit(man);
   else if (man->count != SIZE_MAX)
     man->count--;
 }
 
+/* Called from OCaml finalizers instead of dereferencing node
+   immediately. The node, and the reference to the manager held by the
+   finalized value, are released by the next cuddauxManFlushDerefs, or
+   right away if the manager is not held by anything else (its own
+   value having been finalized before its nodes). */
+void cuddauxManDeferDeref(struct CuddauxMan* man, DdNode* node)
+{
+  if (man->npending==man->maxpending){
+    size_t maxpending = man->maxpending==0 ? 1024 : 2*man->maxpending;
+    DdNode** pending = (DdNode**)realloc(man->pending,maxpending*sizeof(DdNode*));
+    if (pending==NULL){
+      Cudd_RecursiveDeref(man->man,node);
+      cuddauxManFree(man);
+      return;
+    }
+    man->pending = pending;
+    man->maxpending = maxpending;
+  }
+  man->pending[man->npending++] = node;
+  if (man->count==man->npending)
+    cuddauxManQuit(man);
+}
+
+/* Dereferences in bulk the nodes given to cuddauxManDeferDeref. The
+   caller should hold a reference to the manager. */
+void cuddauxManFlushDerefs(struct CuddauxMan* man)
+{
+  size_t i,n = man->npending;
+
+  for (i=0; i<n; i++)
+    Cudd_RecursiveDeref(man->man,man->pending[i]);
+  man->npending = 0;
+  if (man->count != SIZE_MAX){
+    assert(man->count>n);
+    man->count -= n;
+  }
+}
+
 /* ********************************************************************** */
 /* CuddauxCache */
 /* ********************************************************************** */
@@ -78,16 +131,139 @@ DdHashTable* cuddauxHashReinit(struct CuddauxMan* man, struct CuddauxHash* hash)
 			hash->initialsize);
     if (hash->hash == NULL)
       man->man->errorCode = CUDD_MEMORY_OUT;
-    else
+    else {
       hash->man = cuddauxManCopy(man);
+      hash->prev = NULL;
+      hash->next = man->hashes;
+      if (man->hashes) man->hashes->prev = hash;
+      man->hashes = hash;
+    }
   }
   return hash->hash;
 }
 
+/* Removes the entries of the table with a dead key. Keys are not
+   referenced by CUDD hash tables, so that such entries would become
+   invalid as soon as their key is garbage collected. Returns true if
+   an entry has been removed: dereferencing its value may have killed
+   the key of another entry, of this table or of another one. */
+bool cuddauxHashPrune(struct CuddauxHash* hash)
+{
+  DdHashTable* table = hash->hash;
+  DdHashItem *item, *prev, *next;
+  unsigned int i,j;
+  bool dead, removed = false;
+
+  for (i=0; i<table->numBuckets; i++){
+    prev = NULL;
+    item = table->bucket[i];
+    while (item!=NULL){
+      next = item->next;
+      dead = false;
+      for (j=0; j<table->keysize; j++){
+	if (Cudd_Regular(item->key[j])->ref==0){
+	  dead = true; break;
+	}
+      }
+      if (dead){
+	Cudd_RecursiveDeref(table->manager,item->value);
+	if (prev==NULL) table->bucket[i] = next;
+	else prev->next = next;
+	item->next = table->nextFree;
+	table->nextFree = item;
+	table->size--;
+	removed = true;
+      }
+      else
+	prev = item;
+      item = next;
+    }
+  }
+  return removed;
+}
+
+/* References (pin==true) the keys of the table, or dereferences
+   (pin==false) the keys referenced by the last pinning. Referenced
+   nodes keep both their address and their function during a
+   reordering, so that pinned entries remain valid. The referenced keys
+   are recorded, because entries may be added or removed between the
+   pinning and the unpinning (when a reordering fails, its post hook is
+   not run, and the keys are only unpinned by the next reordering). The
+   table should have been pruned before pinning, so that no dead node
+   is referenced. Returns false if the record cannot be allocated. */
+bool cuddauxHashPin(struct CuddauxHash* hash, bool pin)
+{
+  DdHashTable* table = hash->hash;
+  DdHashItem* item;
+  unsigned int i,j;
+  size_t n;
+
+  if (pin){
+    assert(hash->pins==NULL);
+    n = (size_t)table->size * table->keysize;
+    if (n==0) return true;
+    hash->pins = (DdNode**)malloc(n*sizeof(DdNode*));
+    if (hash->pins==NULL) return false;
+    n = 0;
+    for (i=0; i<table->numBuckets; i++){
+      for (item=table->bucket[i]; item!=NULL; item=item->next){
+	for (j=0; j<table->keysize; j++){
+	  assert(Cudd_Regular(item->key[j])->ref>0);
+	  cuddRef(item->key[j]);
+	  hash->pins[n++] = item->key[j];
+	}
+      }
+    }
+    hash->npins = n;
+  }
+  else if (hash->pins!=NULL){
+    for (n=0; n<hash->npins; n++)
+      Cudd_RecursiveDeref(table->manager,hash->pins[n]);
+    free(hash->pins);
+    hash->pins = NULL;
+    hash->npins = 0;
+  }
+  return true;
+}
+
+/* Prunes the tables of the manager until no entry is removed, the
+   value of a removed entry being possibly the last reference to the
+   key of an entry already scanned. */
+void cuddauxManPruneHashes(struct CuddauxMan* man)
+{
+  struct CuddauxHash* hash;
+  bool removed;
+  do {
+    removed = false;
+    for (hash=man->hashes; hash!=NULL; hash=hash->next){
+      if (cuddauxHashPrune(hash)) removed = true;
+    }
+  } while (removed);
+}
+
+bool cuddauxManPinHashes(struct CuddauxMan* man, bool pin)
+{
+  struct CuddauxHash* hash;
+  for (hash=man->hashes; hash!=NULL; hash=hash->next){
+    if (!cuddauxHashPin(hash,pin)) return false;
+  }
+  return true;
+}
+
 /* ********************************************************************** */
 /* common__t */
 /* ********************************************************************** */
 
+/* Names of the built-in operations, whose pids point to the counters
+   of their manager */
+const char* cuddauxBuiltinName[CUDDAUX_BUILTIN_NB] = {
+  "bdd_vectorcompose_memo",
+  "add_vectorcompose_memo",
+  "bdd_permute_memo",
+  "add_permute_memo",
+  "add_vectorcompose"
+};
+
 DdNode* cuddauxCommonLookupN(struct common* common, DdNode** tab)
 {
   int i;
@@ -122,6 +298,7 @@ DdNode* cuddauxCommonLookupN(struct common* common, DdNode** tab)
       abort();
     }
   }
+  cuddauxProfileLookup(common,res);
   return res;
 }
 
@@ -168,3 +345,100 @@ DdNode* cuddauxCommonInsertN(struct common* common, DdNode** tab, DdNode* res)
   }
   return res;
 }
+
+/* ********************************************************************** */
+/* CuddauxBatch */
+/* ********************************************************************** */
+
+static DdNode* cuddauxHashTableLookupN(DdHashTable* hash, DdNode** tab)
+{
+  switch (hash->keysize){
+  case 1:
+    return cuddHashTableLookup1(hash,tab[0]);
+  case 2:
+    return cuddHashTableLookup2(hash,tab[0],tab[1]);
+  case 3:
+    return cuddHashTableLookup3(hash,tab[0],tab[1],tab[2]);
+  default:
+    return cuddHashTableLookup(hash,tab);
+  }
+}
+/* Entries are inserted with a saturated count, so that lookups never
+   remove them */
+static int cuddauxHashTableInsertN(DdHashTable* hash, DdNode** tab, DdNode* res)
+{
+  ptrint count = (ptrint)DD_MAXREF;
+  switch (hash->keysize){
+  case 1:
+    return cuddHashTableInsert1(hash,tab[0],res,count);
+  case 2:
+    return cuddHashTableInsert2(hash,tab[0],tab[1],res,count);
+  case 3:
+    return cuddHashTableInsert3(hash,tab[0],tab[1],tab[2],res,count);
+  default:
+    return cuddHashTableInsert(hash,tab,res,count);
+  }
+}
+
+struct CuddauxBatch* cuddauxBatchInit(DdManager* dd, int arity)
+{
+  struct CuddauxBatch* batch;
+
+  batch = malloc(sizeof(struct CuddauxBatch));
+  if (batch==NULL) goto cuddauxBatchInit_error;
+  batch->arity = arity;
+  batch->size = 0;
+  batch->maxsize = 64;
+  batch->pending = malloc(batch->maxsize*arity*sizeof(DdNode*));
+  batch->table = cuddHashTableInit(dd,arity,256);
+  batch->recur = cuddHashTableInit(dd,arity,2);
+  if (batch->pending==NULL || batch->table==NULL || batch->recur==NULL){
+    cuddauxBatchQuit(batch);
+    goto cuddauxBatchInit_error;
+  }
+  return batch;
+ cuddauxBatchInit_error:
+  dd->errorCode = CUDD_MEMORY_OUT;
+  return NULL;
+}
+void cuddauxBatchQuit(struct CuddauxBatch* batch)
+{
+  if (batch->table) cuddHashTableQuit(batch->table);
+  if (batch->recur) cuddHashTableQuit(batch->recur);
+  free(batch->pending);
+  free(batch);
+}
+DdNode* cuddauxBatchLookup(struct CuddauxBatch* batch, DdNode** tab)
+{
+  return cuddauxHashTableLookupN(batch->table,tab);
+}
+int cuddauxBatchInsert(struct CuddauxBatch* batch, DdNode** tab, DdNode* res)
+{
+  return cuddauxHashTableInsertN(batch->table,tab,res);
+}
+int cuddauxBatchRecurLookup(struct CuddauxBatch* batch, DdNode** tab)
+{
+  return cuddauxHashTableLookupN(batch->recur,tab)!=NULL;
+}
+int cuddauxBatchRecurInsert(struct CuddauxBatch* batch, DdNode** tab)
+{
+  return cuddauxHashTableInsertN(batch->recur,tab,DD_ONE(batch->recur->manager));
+}
+int cuddauxBatchPush(struct CuddauxBatch* batch, DdNode** tab)
+{
+  int i;
+
+  if (batch->size==batch->maxsize){
+    DdNode** pending = realloc(batch->pending,2*batch->maxsize*batch->arity*sizeof(DdNode*));
+    if (pending==NULL){
+      batch->table->manager->errorCode = CUDD_MEMORY_OUT;
+      return 0;
+    }
+    batch->pending = pending;
+    batch->maxsize *= 2;
+  }
+  for (i=0;i<batch->arity;i++)
+    batch->pending[batch->size*batch->arity+i] = tab[i];
+  batch->size++;
+  return 1;
+}
@@ -0,0 +1,213 @@
+(** Images by partitioned transition relations *)
+
+open Format
+
+type stat = {
+  step : int;
+  cluster_size : int;
+  quantified : int;
+  result_size : int;
+}
+
+type 'a step = {
+  cluster : 'a Bdd.t;
+  size : int;           (* size of cluster *)
+  cube : 'a Bdd.t;      (* variables quantified with the cluster *)
+  nquant : int;         (* number of these variables *)
+}
+
+type 'a schedule = {
+  cube0 : 'a Bdd.t;     (* variables on which no cluster depends *)
+  nquant0 : int;
+  steps : 'a step array;
+}
+
+type 'a t = {
+  swap : int array;     (* permutation exchanging cur and next *)
+  post : 'a schedule;
+  pre : 'a schedule;
+}
+
+(*  ********************************************************************** *)
+(** {3 Scheduling} *)
+(*  ********************************************************************** *)
+
+let cube_of_list (man:'a Man.t) (vars:int list) : 'a Bdd.t =
+  List.fold_left
+    (fun cube var -> Bdd.dand cube (Bdd.ithvar man var))
+    (Bdd.dtrue man) vars
+
+(* Greedy ordering of elements of supports [supports]: selects at each
+   step the element which maximizes the number of variables of [quant]
+   it eliminates (i.e., on which no other remaining element depends)
+   minus the number of variables it introduces, ties being broken by
+   the smallest support. Returns the list of pairs [(index, eliminated
+   variables)]. *)
+let schedule
+    (nvars:int) (supports:int list array) (quant:bool array)
+    :
+    (int * int list) list
+    =
+  let count = Array.make nvars 0 in
+  Array.iter (List.iter (fun v -> count.(v) <- count.(v)+1)) supports;
+  let live = Array.make nvars false in
+  let eliminated i =
+    List.filter (fun v -> quant.(v) && count.(v)=1) supports.(i)
+  in
+  let score i =
+    let intro =
+      List.fold_left (fun n v -> if live.(v) then n else n+1) 0 supports.(i)
+    in
+    (List.length (eliminated i)) - intro
+  in
+  let remaining = ref (Array.to_list (Array.init (Array.length supports) (fun i -> i))) in
+  let res = ref [] in
+  while !remaining<>[] do
+    let (best,_,_) =
+      List.fold_left
+	(fun ((_,bscore,bsize) as acc) i ->
+	  let score = score i in
+	  let size = List.length supports.(i) in
+	  if score>bscore || (score=bscore && size<bsize)
+	  then (i,score,size)
+	  else acc)
+	(-1,min_int,max_int) !remaining
+    in
+    let elim = eliminated best in
+    List.iter (fun v -> count.(v) <- count.(v)-1; live.(v) <- true) supports.(best);
+    List.iter (fun v -> live.(v) <- false) elim;
+    remaining := List.filter (fun i -> i<>best) !remaining;
+    res := (best,elim) :: !res
+  done;
+  List.rev !res
+
+(*  ********************************************************************** *)
+(** {3 Construction} *)
+(*  ********************************************************************** *)
+
+let make
+    ?(threshold=5000) ?(inputs=[||])
+    (man:'a Man.t) ~(cur:int array) ~(next:int array)
+    (conjuncts:'a Bdd.t list)
+    :
+    'a t
+    =
+  let nvars = Man.get_bddvar_nb man in
+  if Array.length cur <> Array.length next then
+    raise (Invalid_argument "Cudd.Image.make: cur and next have different lengths");
+  let check var =
+    if var<0 || var>=nvars then
+      raise (Invalid_argument "Cudd.Image.make: variable not in the manager")
+  in
+  Array.iter check cur; Array.iter check next; Array.iter check inputs;
+  let quant vars =
+    let quant = Array.make nvars false in
+    Array.iter (fun v -> quant.(v) <- true) vars;
+    Array.iter (fun v -> quant.(v) <- true) inputs;
+    quant
+  in
+  let qpost = quant cur in
+  let qpre = quant next in
+  let support_of bdd = Bdd.list_of_support (Bdd.support bdd) in
+  (* Clustering of consecutive conjuncts, in the order of the schedule
+     for post *)
+  let conjuncts = Array.of_list conjuncts in
+  (* Conjunction of a cluster and a conjunct, if its size does not
+     exceed [threshold]; the conjunction gives up as soon as it has
+     allocated more than [threshold] nodes, so that oversized products
+     are not built *)
+  let merge cluster conjunct =
+    if threshold<=0 then None
+    else
+      try
+	let product =
+	  Man.with_limits ~nodes:threshold man
+	    (fun () -> Bdd.dand cluster conjunct)
+	in
+	if Bdd.size product <= threshold then Some product else None
+      with Man.Timeout -> None
+  in
+  let clusters =
+    let order = schedule nvars (Array.map support_of conjuncts) qpost in
+    let (res,last) =
+      List.fold_left
+	(fun (res,cluster) (i,_) ->
+	  let conjunct = conjuncts.(i) in
+	  match cluster with
+	  | None -> (res, Some conjunct)
+	  | Some cluster ->
+	      match merge cluster conjunct with
+	      | Some product -> (res, Some product)
+	      | None -> (cluster::res, Some conjunct))
+	([],None) order
+    in
+    let res = match last with None -> res | Some cluster -> cluster::res in
+    Array.of_list (List.rev res)
+  in
+  let supports = Array.map support_of clusters in
+  let make_schedule quant =
+    let vars = ref [] in
+    for v=nvars-1 downto 0 do
+      if quant.(v) then vars := v :: !vars
+    done;
+    let qcube = cube_of_list man !vars in
+    let cube0 =
+      if Array.length clusters = 0
+      then qcube
+      else Bdd.support_diff qcube (Bdd.vectorsupport clusters)
+    in
+    let steps =
+      List.map
+	(fun (i,elim) -> {
+	  cluster = clusters.(i);
+	  size = Bdd.size clusters.(i);
+	  cube = cube_of_list man elim;
+	  nquant = List.length elim;
+	})
+	(schedule nvars supports quant)
+    in
+    { cube0 = cube0; nquant0 = Bdd.supportsize cube0; steps = Array.of_list steps }
+  in
+  let swap = Array.init nvars (fun i -> i) in
+  Array.iteri
+    (fun i c ->
+      swap.(c) <- next.(i);
+      swap.(next.(i)) <- c)
+    cur;
+  { swap = swap; post = make_schedule qpost; pre = make_schedule qpre }
+
+let clusters (t:'a t) : 'a Bdd.t array =
+  Array.map (fun step -> step.cluster) t.post.steps
+
+(*  ********************************************************************** *)
+(** {3 Images} *)
+(*  ********************************************************************** *)
+
+let image ?stat (schedule:'a schedule) (set:'a Bdd.t) : 'a Bdd.t =
+  let res = ref (Bdd.exist schedule.cube0 set) in
+  let report step cluster_size quantified =
+    match stat with
+    | None -> ()
+    | Some f ->
+	f { step = step; cluster_size = cluster_size;
+	    quantified = quantified; result_size = Bdd.size !res }
+  in
+  report (-1) 0 schedule.nquant0;
+  let i = ref 0 in
+  while !i < Array.length schedule.steps && not (Bdd.is_false !res) do
+    let step = schedule.steps.(!i) in
+    res := Bdd.existand step.cube step.cluster !res;
+    report !i step.size step.nquant;
+    incr i
+  done;
+  !res
+
+let post ?stat (t:'a t) (set:'a Bdd.t) : 'a Bdd.t =
+  Bdd.permute (image ?stat t.post set) t.swap
+
+let pre ?stat (t:'a t) (set:'a Bdd.t) : 'a Bdd.t =
+  image ?stat t.pre (Bdd.permute set t.swap)
+
+let print_stat fmt (stat:stat) =
+  fprintf fmt "{ step=%i; cluster_size=%i; quantified=%i; result_size=%i }"
+    stat.step stat.cluster_size stat.quantified stat.result_size
@@ -0,0 +1,59 @@
+(** Images by partitioned transition relations *)
+
+(** This module computes images and preimages by a transition
+    relation given as a conjunction of BDDs, without building the
+    monolithic relation. Conjuncts are grouped into clusters, the
+    size of which is bounded by a threshold, and clusters are ordered
+    by a quantification schedule (in the spirit of the IWLS95
+    heuristic), so that each variable to be quantified is eliminated
+    by {!Bdd.existand} as soon as the remaining clusters do not depend
+    on it. *)
+
+type 'a t
+  (** Partitioned transition relation, on a manager of type ['a Man.t] *)
+
+type stat = {
+  step : int;
+    (** Index of the cluster in the schedule, or [-1] for the
+        quantification of the variables on which no cluster depends *)
+  cluster_size : int;
+    (** Size of the cluster ([0] for the step [-1]) *)
+  quantified : int;
+    (** Number of variables quantified at this step *)
+  result_size : int;
+    (** Size of the intermediate result after this step *)
+}
+  (** Statistics on a step of an image computation *)
+
+val make :
+  ?threshold:int -> ?inputs:int array ->
+  'a Man.t -> cur:int array -> next:int array -> 'a Bdd.t list -> 'a t
+  (** [make man ~cur ~next conjuncts] builds the transition relation
+      [T(cur,inputs,next)] which is the conjunction of [conjuncts].
+      [cur.(i)] and [next.(i)] are the indices of the current and next
+      copies of the i-th state variable, and [inputs] (default [[||]])
+      the indices of other variables, which are quantified in both
+      directions.
+
+      Consecutive conjuncts are merged while the size of the cluster
+      does not exceed [threshold] (default [5000]; a non-positive
+      value keeps one cluster per conjunct). The conjunctions giving
+      larger clusters are abandoned as soon as they have allocated
+      [threshold] nodes.
+
+      Raises [Invalid_argument] if [cur] and [next] have different
+      lengths or contain indices not in the manager. *)
+
+val post : ?stat:(stat -> unit) -> 'a t -> 'a Bdd.t -> 'a Bdd.t
+  (** [post t set] returns the image [exists cur,inputs: set(cur) /\
+      T(cur,inputs,next)], renamed on [cur] variables. If given, [stat]
+      is called after each step. *)
+
+val pre : ?stat:(stat -> unit) -> 'a t -> 'a Bdd.t -> 'a Bdd.t
+  (** [pre t set] returns the preimage [exists next,inputs: set(next) /\
+      T(cur,inputs,next)], where [set] is given on [cur] variables. *)
+
+val clusters : 'a t -> 'a Bdd.t array
+  (** Clusters of the relation, in the order of the schedule of {!post} *)
+
+val print_stat : Format.formatter -> stat -> unit
@@ -26,10 +26,9 @@ let combineleaf1
     'c
     =
   let res = ref default in
-  let leaves = Vdd.leaves vdd in
-  for i=0 to pred (Array.length leaves) do
-    let leaf = leaves.(i) in
-    let guard = Vdd.guard_of_leaf vdd leaves.(i) in
+  let guardleafs = Vdd.guardleafs vdd in
+  for i=0 to pred (Array.length guardleafs) do
+    let (guard,leaf) = guardleafs.(i) in
     let result = f guard leaf in
     res := combine result !res
   done;
@@ -83,16 +82,14 @@ let combineleaf2
     'd
     =
   let res = ref default in
-  let leaves1 = Vdd.leaves vdd1 in
+  let guardleafs1 = Vdd.guardleafs vdd1 in
   if !restrict then begin
-    for i1=0 to pred (Array.length leaves1) do
-      let leaf1 = leaves1.(i1) in
-      let guard1 = Vdd.guard_of_leaf vdd1 leaf1 in
+    for i1=0 to pred (Array.length guardleafs1) do
+      let (guard1,leaf1) = guardleafs1.(i1) in
       let vdd2 = Vdd.restrict vdd2 guard1 in
-      let leaves2 = Vdd.leaves vdd2 in
-      for i2=0 to pred (Array.length leaves2) do
-	let leaf2 = leaves2.(i2) in
-	let guard2 = Vdd.guard_of_leaf vdd2 leaf2 in
+      let guardleafs2 = Vdd.guardleafs vdd2 in
+      for i2=0 to pred (Array.length guardleafs2) do
+	let (guard2,leaf2) = guardleafs2.(i2) in
 	let guard = Bdd.dand guard1 guard2 in
 	if not (Bdd.is_false guard) then begin
 	  let result = f guard leaf1 leaf2 in
@@ -103,9 +100,8 @@ let combineleaf2
   end
   else begin
     let guardleafs2 = Vdd.guardleafs vdd2 in
-    for i1=0 to pred (Array.length leaves1) do
-      let leaf1 = leaves1.(i1) in
-      let guard1 = Vdd.guard_of_leaf vdd1 leaf1 in
+    for i1=0 to pred (Array.length guardleafs1) do
+      let (guard1,leaf1) = guardleafs1.(i1) in
       for i2=0 to pred (Array.length guardleafs2) do
 	let (guard2,leaf2) = guardleafs2.(i2) in
 	let guard = Bdd.dand guard1 guard2 in
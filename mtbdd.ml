@@ -42,3 +42,7 @@ let guardleafs_u = guardleafs
 
 let cst_u = cst
 let cst cudd table v = cst cudd (unique table v)
+
+let output ~encode chan tdd = Vdd.output ~encode:(fun x -> encode (get x)) chan tdd
+let input ~decode table man chan =
+  Vdd.input ~decode:(fun str -> unique table (decode str)) man chan
@@ -199,6 +199,14 @@ Two options:
 
 external transfer : 'a t -> Man.v Man.t -> 'a t = "camlidl_cudd_add_transfer"
 
+val output : encode:('a -> string) -> out_channel -> 'a t array -> unit
+  (** [output ~encode chan tmtbdd] writes the array of MTBDDs on the
+      channel, in binary form (see {!Vdd.output}). Leaves are encoded
+      with [encode]; identical encodings are written once. *)
+val input : decode:(string -> 'a) -> 'a table -> Man.v Man.t -> in_channel -> 'a t array
+  (** [input ~decode table man chan] reads an array of MTBDDs written
+      by {!output}. The decoded leaves are made unique with [table]. *)
+
 (* ====================================================== *)
 (** {3 Printing} *)
 (* ====================================================== *)
@@ -120,6 +120,9 @@ external tdrestrict : 'a t -> Man.v Bdd.t -> 'a t
   = "camlidl_cudd_add_tdrestrict"
 
 external transfer : 'a t -> Man.v Man.t -> 'a t = "camlidl_cudd_add_transfer"
+let output ~encode chan t = Vdd.output ~encode:(fun x -> encode x.content) chan t
+let input ~decode table man chan =
+  Vdd.input ~decode:(fun str -> unique table (decode str)) man chan
 let print__minterm print_leaf fmt t =
   Vdd.print__minterm (fun fmt x -> print_leaf fmt x.content) fmt t
 let print_minterm print_id print_leaf fmt t =
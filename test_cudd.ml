@@ -0,0 +1,680 @@
+(* Regression tests on the reference counting of the C stubs.
+
+   Each test runs on a fresh manager, checks its results with assert,
+   and prints its name when it succeeds. Leaks and reference count
+   underflows are detected by checking that the number of live nodes
+   comes back to its initial value once the diagrams built by the test
+   have been collected, and with Man.debugcheck.
+
+   Usage: test_cudd.opt [test ...] (all tests by default), or
+   "make test" in the source directory.
+*)
+
+open Format
+open Cudd
+
+(*  ********************************************************************** *)
+(** {2 Utilities} *)
+(*  ********************************************************************** *)
+
+let collect (man:'a Man.t) : int =
+  Gc.full_major ();
+  ignore (Man.garbage_collect man);
+  Man.get_node_count man
+
+(* Runs [f man] on a fresh manager and checks that it neither leaks nor
+   frees nodes still in use *)
+let check_nodes (man:'a Man.t) (f:'a Man.t -> unit) : unit =
+  let nodes = collect man in
+  f man;
+  assert (collect man = nodes);
+  assert (Man.debugcheck man)
+
+(* Resident size of the process in kilobytes, or [None] if it is not
+   available *)
+let resident () : int option =
+  try
+    let chan = open_in "/proc/self/statm" in
+    let pages = Scanf.fscanf chan "%_d %d" (fun n -> n) in
+    close_in chan;
+    Some (pages*4)
+  with _ -> None
+
+(*  ********************************************************************** *)
+(** {2 Tests} *)
+(*  ********************************************************************** *)
+
+(* A reordering failing before its post hook leaves the hash tables of
+   the manager pinned; entries added afterwards should not be unpinned by
+   the next reordering *)
+let failed_reordering () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let hash = Hash.create 1 in
+    let memo = Memo.Hash hash in
+    let x i = Bdd.ithvar man i in
+    let table = Array.init 8 (fun i -> Bdd.xor (x i) (x ((i+1) mod 8))) in
+    let f = Bdd.dor (Bdd.dand (x 0) (x 5)) (Bdd.dand (x 2) (x 7)) in
+    let f1 = Bdd.vectorcompose ~memo table f in
+    (* CUDD rejects the group sifting with this aggregation method *)
+    Man.set_groupcheck man Man.GROUP_CHECK;
+    begin try
+      Man.reduce_heap man Man.REORDER_GROUP_SIFT 0;
+      assert false
+    with Failure _ -> ()
+    end;
+    Man.set_groupcheck man Man.NO_CHECK;
+    (* new entries, with keys which are not pinned *)
+    let g = Bdd.dand (Bdd.xor (x 1) (x 4)) (Bdd.dor (x 3) (x 6)) in
+    let g1 = Bdd.vectorcompose ~memo table g in
+    Man.reduce_heap man Man.REORDER_SIFT 0;
+    Man.reduce_heap man Man.REORDER_SIFT 0;
+    assert (Bdd.is_equal f1 (Bdd.vectorcompose table f));
+    assert (Bdd.is_equal g1 (Bdd.vectorcompose table g));
+    assert (Bdd.is_equal g1 (Bdd.vectorcompose ~memo table g));
+    Hash.clear hash
+  )
+
+(* A manager whose value is finalized before its nodes should be freed
+   with its last node *)
+let manager_lifetime () =
+  let round () =
+    let nodes =
+      let man = Man.make_d ~numVars:16 ~cacheSize:(1 lsl 18) () in
+      Array.init 16
+	(fun i -> Bdd.dand (Bdd.ithvar man i) (Bdd.ithvar man ((i+1) mod 16)))
+    in
+    (* the value of the manager is finalized first *)
+    Gc.full_major ();
+    assert (Array.length nodes = 16)
+  in
+  round ();
+  Gc.full_major ();
+  let before = resident () in
+  for i=1 to 64 do round () done;
+  Gc.full_major ();
+  match (before,resident ()) with
+  | (Some before, Some after) ->
+      (* each manager allocates several megabytes for its cache *)
+      assert (after - before < 64*1024)
+  | _ -> ()
+
+(* Sum of products of pairs of distant variables, the size of which is
+   exponential in n *)
+let pairs (man:'a Man.t) (n:int) (shift:int) : 'a Bdd.t =
+  let res = ref (Bdd.dfalse man) in
+  for i=0 to n-1 do
+    let y = Bdd.ithvar man (n + (i+shift) mod n) in
+    res := Bdd.dor !res (Bdd.dand (Bdd.ithvar man i) y)
+  done;
+  !res
+
+(* An operation exceeding the limits gives up, leaving the manager
+   consistent and usable *)
+let timeout () =
+  let man = Man.make_d ~numVars:24 () in
+  check_nodes man (fun man ->
+    let f = pairs man 12 0 in
+    let g = pairs man 12 5 in
+    Man.set_limits ~steps:100 man;
+    begin try ignore (Bdd.xor f g); assert false
+    with Man.Timeout -> ()
+    end;
+    assert (Man.check_keys man = 0);
+    Man.clear_limits man;
+    let h = Bdd.xor f g in
+    assert (Bdd.is_equal (Bdd.dnot h) (Bdd.nxor f g));
+    assert (Man.check_keys man = 0)
+  )
+
+(* The operations performed by the callbacks of a User operation do not
+   restart the limits of the manager *)
+let timeout_user () =
+  let man = Man.make_v ~numVars:16 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let sum n =
+      let res = ref (Vdd.cst man 0) in
+      for i=0 to n-1 do
+	let v = Vdd.ite (x i) (Vdd.cst man (1 lsl i)) (Vdd.cst man 0) in
+	res := User.map_op2 (+) !res v
+      done;
+      !res
+    in
+    let f = sum 12 in
+    Man.set_limits ~steps:200 man;
+    begin try
+      ignore
+	(User.map_op2
+	   (fun a b -> ignore (Bdd.dand (x 14) (x 15)); a*b+1) f f);
+      assert false
+    with Man.Timeout -> ()
+    end;
+    Man.clear_limits man;
+    assert (Man.check_keys man = 0)
+  )
+
+(* The multi-root compositions agree with the single-root ones, and
+   release the references of their results exactly once *)
+let compose_array () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let table = Array.init 8 (fun i -> Bdd.dand (x i) (x ((i+3) mod 8))) in
+    let tab =
+      Array.init 6
+	(fun i -> Bdd.dor (Bdd.xor (x i) (x (i+1))) (Bdd.dand (x (i+2)) (x 7)))
+    in
+    let permut = Array.init 8 (fun i -> (i+5) mod 8) in
+    let res = Bdd.vectorcompose_array table tab in
+    Array.iteri
+      (fun i f -> assert (Bdd.is_equal f (Bdd.vectorcompose table tab.(i))))
+      res;
+    let res = Bdd.permute_array tab permut in
+    Array.iteri
+      (fun i f -> assert (Bdd.is_equal f (Bdd.permute tab.(i) permut)))
+      res;
+    let hash = Hash.create 1 in
+    let res = Bdd.vectorcompose_array ~memo:(Memo.Hash hash) table tab in
+    Array.iteri
+      (fun i f -> assert (Bdd.is_equal f (Bdd.vectorcompose table tab.(i))))
+      res;
+    Hash.clear hash;
+    assert (Bdd.vectorcompose_array table [||] = [||]);
+    let other = Man.make_d ~numVars:8 () in
+    begin try
+      ignore (Bdd.vectorcompose_array (Array.map (fun _ -> Bdd.dtrue other) table) tab);
+      assert false
+    with Invalid_argument _ -> ()
+    end
+  )
+
+(* The sparse substitutions agree with the dense ones, and reject
+   variables substituted twice *)
+let compose_sparse () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let f = Bdd.dor (Bdd.xor (x 0) (x 3)) (Bdd.dand (x 5) (Bdd.dnot (x 6))) in
+    let subst = [| (3, Bdd.dand (x 1) (x 2)); (6, Bdd.xor (x 0) (x 7)) |] in
+    let table = Array.init 8 x in
+    Array.iter (fun (var,g) -> table.(var) <- g) subst;
+    assert (Bdd.is_equal
+	      (Bdd.vectorcompose_sparse subst f) (Bdd.vectorcompose table f));
+    (* a renaming which is not injective *)
+    let renaming = [| (0, 5); (3, 5); (6, 2) |] in
+    let permut = Array.init 8 (fun i -> i) in
+    Array.iter (fun (var,var') -> permut.(var) <- var') renaming;
+    assert (Bdd.is_equal
+	      (Bdd.permute_sparse f renaming) (Bdd.permute f permut));
+    begin try
+      ignore (Bdd.vectorcompose_sparse [| (3, x 1); (3, x 2) |] f);
+      assert false
+    with Invalid_argument _ -> ()
+    end;
+    begin try
+      ignore (Bdd.permute_sparse f [| (0, 1); (0, 2) |]);
+      assert false
+    with Invalid_argument _ -> ()
+    end
+  )
+
+(* The values of a hash table may be the only references to the keys
+   of another one: pruning the first table before a garbage collection
+   kills keys of the second one, which should be pruned as well rather
+   than keep entries on freed nodes *)
+let chained_hashes () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let table1 = Array.init 8 (fun i -> Bdd.xor (x i) (x ((i+1) mod 8))) in
+    let table2 = Array.init 8 (fun i -> Bdd.dand (x i) (x ((i+3) mod 8))) in
+    let hash1 = Hash.create 1 in
+    let hash2 = Hash.create 1 in
+    begin
+      let f = pairs man 4 1 in
+      (* two references, so that the root is memoized *)
+      let f' = Bdd.dand f f in
+      let f1 = Bdd.vectorcompose ~memo:(Memo.Hash hash1) table1 f' in
+      let f1' = Bdd.dand f1 f1 in
+      let f2 = Bdd.vectorcompose ~memo:(Memo.Hash hash2) table2 f1' in
+      assert (Bdd.is_equal f2 (Bdd.vectorcompose table2 f1));
+      assert (Hash.size hash2 > 0)
+    end;
+    ignore (collect man);
+    let size1 = Hash.size hash1 and size2 = Hash.size hash2 in
+    (* a second garbage collection finds no more dead keys *)
+    ignore (collect man);
+    assert (Hash.size hash1 = size1 && Hash.size hash2 = size2);
+    Hash.clear hash1;
+    Hash.clear hash2
+  )
+
+(* The finalized diagrams wait in the buffer of the manager until it is
+   flushed, which neither get_pending_derefs nor flush_derefs does
+   through the conversion of their argument *)
+let pending_derefs () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    Man.flush_derefs man;
+    assert (Man.get_pending_derefs man = 0);
+    begin
+      let x i = Bdd.ithvar man i in
+      let tab = Array.init 8 (fun i -> Bdd.dand (x i) (x ((i+1) mod 8))) in
+      assert (Array.length tab = 8)
+    end;
+    Gc.full_major ();
+    assert (Man.get_pending_derefs man > 0);
+    Man.flush_derefs man;
+    assert (Man.get_pending_derefs man = 0)
+  )
+
+(* The limits of nested calls of with_limits and of set_limits are all
+   enforced, and the enclosing limits are not restarted by the inner
+   calls *)
+let nested_limits () =
+  let man = Man.make_d ~numVars:24 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let f = pairs man 12 0 in
+    let g = pairs man 12 5 in
+    let timeout f =
+      try ignore (f ()); false with Man.Timeout -> true
+    in
+    (* the enclosing limit is tighter *)
+    assert (timeout (fun () ->
+      Man.with_limits ~steps:100 man (fun () ->
+	Man.with_limits ~steps:100_000_000 man (fun () -> Bdd.xor f g))));
+    (* the enclosing budget is not restarted when leaving inner calls *)
+    assert (timeout (fun () ->
+      Man.with_limits ~steps:100 man (fun () ->
+	for i=0 to 23 do
+	  for j=i+1 to 23 do
+	    ignore
+	      (Man.with_limits ~steps:100_000_000 man
+		 (fun () -> Bdd.dand (x i) (Bdd.dnot (x j))))
+	  done
+	done)));
+    (* the limits of set_limits apply inside with_limits *)
+    Man.set_limits ~steps:100 man;
+    assert (timeout (fun () ->
+      Man.with_limits ~steps:100_000_000 man (fun () -> Bdd.xor f g)));
+    Man.clear_limits man;
+    (* no limit is left *)
+    let h = Bdd.xor f g in
+    assert (Bdd.is_equal (Bdd.dnot h) (Bdd.nxor f g));
+    assert (Man.check_keys man = 0)
+  )
+
+(* The fused operations give the same result as the chained ones,
+   including on the terminal cases of CUDD (0 * infinity = 0, 0 / 0 = 0,
+   infinity - infinity = 0) *)
+let fused () =
+  let man = Man.make_d ~numVars:4 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let cst c = Add.cst man c in
+    let a = Add.ite (x 0) (cst infinity) (cst 2.) in
+    let b = Add.ite (x 1) (cst 0.) (Add.ite (x 3) (cst 1.) (cst 3.)) in
+    let c = Add.ite (x 2) (cst 5.) (cst neg_infinity) in
+    let dag = [|
+      (Add.Times, Add.In 0, Add.In 1);    (* 0 * inf *)
+      (Add.Divide, Add.Node 0, Add.In 1); (* 0 / 0 *)
+      (Add.Minus, Add.Node 1, Add.In 0);  (* inf - inf *)
+      (Add.Plus, Add.Node 2, Add.In 1);
+      (Add.Maximum, Add.Node 3, Add.In 2);
+      (Add.Minimum, Add.Node 4, Add.In 0);
+    |]
+    in
+    let chained =
+      let n0 = Add.mul a b in
+      let n1 = Add.div n0 b in
+      let n2 = Add.sub n1 a in
+      let n3 = Add.add n2 b in
+      let n4 = Add.max n3 c in
+      Add.min n4 a
+    in
+    assert (Add.is_equal (Add.apply_fused dag [|a;b;c|]) chained)
+  )
+
+(* The batched applications give the same results as the per-leaf
+   ones, and call the special function at most once per pair of
+   nodes *)
+let batched () =
+  let man = Man.make_v ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let sum vars =
+      List.fold_left
+	(fun res i ->
+	  User.map_op2 (+) res (Vdd.ite (x i) (Vdd.cst man (i+1)) (Vdd.cst man 0)))
+	(Vdd.cst man 0) vars
+    in
+    let f = sum [0;2;4;6] and g = sum [1;2;5;7] in
+    let calls = ref 0 in
+    let special f g =
+      incr calls;
+      if Vdd.is_cst f && Vdd.dval f = 0 then Some g else None
+    in
+    let op a b = a*b + 1 in
+    let res = User.map_op2 ~special op f g in
+    let calls1 = !calls in
+    calls := 0;
+    assert (Vdd.is_equal (User.map_op2 ~batch:true ~special op f g) res);
+    assert (!calls <= calls1);
+    let op3 a b c = a*b - c in
+    assert (Vdd.is_equal
+	      (User.map_op3 ~batch:true op3 f g f) (User.map_op3 op3 f g f));
+    assert (Vdd.is_equal
+	      (User.map_op1 ~batch:true (fun a -> 2*a) f)
+	      (User.map_op1 (fun a -> 2*a) f))
+  )
+
+(* The native kernels give the same results as the corresponding
+   OCaml leaf operations, including on NaN leaves *)
+let kernels () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let cst c = Add.cst man c in
+    let f = Add.ite (x 0) (cst (-3.)) (Add.ite (x 2) (cst 4.) (cst 1.)) in
+    let g = Add.ite (x 1) (cst 2.) (Add.ite (x 2) (cst (-5.)) (cst 8.)) in
+    let check1 kernel op =
+      assert (Add.is_equal (Add.map_kernel1 kernel f) (Add.map_op1 op f))
+    in
+    let check2 kernel op =
+      assert (Add.is_equal (Add.map_kernel2 kernel f g) (Add.map_op2 op f g))
+    in
+    let checkcmp cmp op f g =
+      let expected =
+	Add.to_bdd (Add.map_op2 (fun a b -> if op a b then 1. else 0.) f g)
+      in
+      assert (Bdd.is_equal (Add.map_cmp cmp f g) expected)
+    in
+    check1 (Add.Affine(2.,1.)) (fun x -> 2.*.x +. 1.);
+    check1 (Add.Clamp(0.,2.))
+      (fun x -> if x < 0. then 0. else if x > 2. then 2. else x);
+    check1 Add.Abs abs_float;
+    check1 (Add.Min_cst 1.) (fun x -> if x <= 1. then x else 1.);
+    check2 (Add.Sat_add(-4.,4.)) (fun x y -> max (-4.) (min 4. (x +. y)));
+    check2 (Add.Affine2(2.,-1.,3.)) (fun x y -> 2.*.x +. (-1.)*.y +. 3.);
+    checkcmp Add.Lt (<) f g;
+    checkcmp Add.Ge (>=) f g;
+    (* a NaN leaf is not related to itself; NaN leaves are not shared by
+       CUDD, so that they appear only in comparisons *)
+    let h = Add.ite (x 5) (cst nan) f in
+    checkcmp Add.Le (<=) h h;
+    checkcmp Add.Eq (=) h h
+  )
+
+(* A compiled expression gives the same result as the chain of
+   operations it replaces *)
+let expr () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let cst c = Add.cst man c in
+    let a = Add.ite (x 0) (cst 3.) (Add.ite (x 3) (cst (-1.)) (cst 2.)) in
+    let b = Add.ite (x 1) (cst 5.) (Add.ite (x 3) (cst 4.) (cst (-2.))) in
+    let c = Bdd.xor (x 2) (x 4) in
+    let open Add.Expr in
+    let e =
+      If(Bvar 0,
+	 Add(Mul(Var 0, Var 1), Cst 1.),
+	 If(Lt(Var 0, Var 1), Max(Neg (Var 0), Var 1), Abs(Sub(Var 1, Var 0))))
+    in
+    let chained =
+      Add.ite c
+	(Add.add (Add.mul a b) (cst 1.))
+	(Add.ite (Add.map_cmp Add.Lt a b)
+	   (Add.max (Add.map_kernel1 (Add.Affine(-1.,0.)) a) b)
+	   (Add.map_kernel1 Add.Abs (Add.sub b a)))
+    in
+    assert (Add.is_equal (Add.map_expr e [|c|] [|a;b|]) chained);
+    let op = Add.make_expr 1 2 e in
+    assert (Add.is_equal (Add.apply_expr op [|c|] [|a;b|]) chained);
+    Add.clear_expr op;
+    begin try ignore (Add.make_expr 0 2 e); assert false
+    with Invalid_argument _ -> ()
+    end
+  )
+
+(* Exported diagrams are rebuilt identically, in the same manager or in
+   a manager with another variable order, and through a file *)
+let persistence () =
+  let man = Man.make_v ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let cst c = Vdd.cst man c in
+    let f = Vdd.ite (x 0) (cst 1) (Vdd.ite (Bdd.xor (x 2) (x 5)) (cst 2) (cst 3)) in
+    let g = Vdd.ite (Bdd.dand (x 1) (x 7)) f (cst 4) in
+    let tab = [| f; g; cst 4 |] in
+    let check tab' =
+      assert (Array.length tab' = Array.length tab);
+      Array.iteri (fun i h -> assert (Vdd.is_equal h tab.(i))) tab'
+    in
+    let (structure,roots,leaves) = Vdd.export tab in
+    check (Vdd.import man leaves structure roots);
+    let other = Man.make_v ~numVars:8 () in
+    Man.shuffle_heap other (Array.init 8 (fun i -> 7-i));
+    let tab2 = Vdd.import other leaves structure roots in
+    check (Array.map (fun h -> Vdd.transfer h man) tab2);
+    let filename = Filename.temp_file "test_cudd" ".vdd" in
+    let chan = open_out_bin filename in
+    Vdd.output ~encode:string_of_int chan tab;
+    close_out chan;
+    let chan = open_in_bin filename in
+    let tab3 = Vdd.input ~decode:int_of_string man chan in
+    close_in chan;
+    Sys.remove filename;
+    check tab3
+  )
+
+(* The guards of the leaves partition the space of valuations, and the
+   diagram is rebuilt from its (guard, leaf) pairs *)
+let guardleafs () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let cst c = Add.cst man c in
+    let f =
+      Add.add
+	(Add.ite (Bdd.xor (x 0) (x 4)) (cst 1.) (cst 2.))
+	(Add.ite (Bdd.dor (x 2) (x 6)) (cst 10.) (cst 20.))
+    in
+    let tab = Add.guardleafs f in
+    assert (Array.length tab = 4);
+    let union = ref (Bdd.dfalse man) in
+    let rebuilt = ref (cst 0.) in
+    Array.iteri
+      (fun i (guard,leaf) ->
+	Array.iteri
+	  (fun j (guard',_) ->
+	    if i<>j then assert (Bdd.is_false (Bdd.dand guard guard')))
+	  tab;
+	assert (Bdd.is_equal guard (Add.guard_of_leaf f leaf));
+	union := Bdd.dor !union guard;
+	rebuilt := Add.ite guard (cst leaf) !rebuilt)
+      tab;
+    assert (Bdd.is_true !union);
+    assert (Add.is_equal !rebuilt f);
+    let tab = Add.guardleafs (cst 3.) in
+    assert (Array.length tab = 1 && Bdd.is_true (fst tab.(0)))
+  )
+
+(* The N-ary operations give the same results as the left folds of the
+   binary ones, whatever the order in which they combine the operands *)
+let apply_array () =
+  let man = Man.make_d ~numVars:12 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let cst c = Add.cst man c in
+    let tab =
+      [| pairs man 4 1; Bdd.xor (x 8) (x 9); x 10;
+	 Bdd.dor (x 0) (Bdd.dnot (x 11)); pairs man 4 2 |]
+    in
+    let fold op tab =
+      Array.fold_left op tab.(0) (Array.sub tab 1 (Array.length tab - 1))
+    in
+    List.iter
+      (fun restrict ->
+	let (res,peak) = Bdd.dand_array ~restrict tab in
+	assert (Bdd.is_equal res (fold Bdd.dand tab));
+	Array.iter (fun f -> assert (peak >= Bdd.size f)) tab;
+	let (res,_) = Bdd.dor_array ~restrict tab in
+	assert (Bdd.is_equal res (fold Bdd.dor tab));
+	(* absorbing operands *)
+	let tab' = Array.append tab [|Bdd.dfalse man|] in
+	assert (Bdd.is_false (fst (Bdd.dand_array ~restrict tab')));
+	let tab' = Array.append [|Bdd.dtrue man|] tab in
+	let (res,_) = Bdd.dor_array ~restrict tab' in
+	assert (Bdd.is_true res))
+      [false;true];
+    let tadd =
+      Array.mapi
+	(fun i f -> Add.ite f (cst (float (i+2))) (cst (float (-i))))
+	tab
+    in
+    assert (Add.is_equal (fst (Add.add_array tadd)) (fold Add.add tadd));
+    assert (Add.is_equal (fst (Add.mul_array tadd)) (fold Add.mul tadd));
+    assert (Add.is_equal (fst (Add.add_array [|tadd.(0)|])) tadd.(0));
+    begin try ignore (Bdd.dand_array [||]); assert false
+    with Invalid_argument _ -> ()
+    end
+  )
+
+(* The images by a partitioned relation are those by the monolithic
+   relation, whatever the size of the clusters *)
+let image () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    (* 3-bit counter incremented when the input 6 is true; the current
+       and next copies of bit i are the variables 2i and 2i+1 *)
+    let cur = [|0;2;4|] and next = [|1;3;5|] in
+    let en = x 6 in
+    let carry =
+      [| en; Bdd.dand en (x 0); Bdd.dand en (Bdd.dand (x 0) (x 2)) |]
+    in
+    let conjuncts =
+      Array.to_list
+	(Array.init 3
+	   (fun i -> Bdd.nxor (x next.(i)) (Bdd.xor (x cur.(i)) carry.(i))))
+    in
+    let rel = List.fold_left Bdd.dand (Bdd.dtrue man) conjuncts in
+    let cube vars = Array.fold_left (fun c v -> Bdd.dand c (x v)) (x 6) vars in
+    let swap = Array.init 8 (fun i -> if i<6 then i lxor 1 else i) in
+    let post set = Bdd.permute (Bdd.existand (cube cur) set rel) swap in
+    let pre set = Bdd.existand (cube next) (Bdd.permute set swap) rel in
+    let sets = [
+      Bdd.dand (Bdd.dnot (x 0)) (Bdd.dand (Bdd.dnot (x 2)) (Bdd.dnot (x 4)));
+      Bdd.xor (x 0) (x 4);
+      Bdd.dtrue man;
+      Bdd.dfalse man;
+    ]
+    in
+    List.iter
+      (fun threshold ->
+	let t = Image.make ~threshold ~inputs:[|6|] man ~cur ~next conjuncts in
+	let steps = ref 0 in
+	let stat _ = incr steps in
+	List.iter
+	  (fun set ->
+	    assert (Bdd.is_equal (Image.post ~stat t set) (post set));
+	    assert (Bdd.is_equal (Image.pre t set) (pre set)))
+	  sets;
+	assert (!steps > 0);
+	let clusters = Image.clusters t in
+	assert (Bdd.is_equal
+		  (Array.fold_left Bdd.dand (Bdd.dtrue man) clusters) rel))
+      [0; 5000]
+  )
+
+(* The fused relational products agree with varmap applied to existand,
+   also once the map has been changed, which invalidates the results
+   cached with the previous map *)
+let relprod_rename () =
+  let man = Man.make_d ~numVars:8 () in
+  check_nodes man (fun man ->
+    let x i = Bdd.ithvar man i in
+    let cube vars =
+      List.fold_left (fun c v -> Bdd.dand c (x v)) (Bdd.dtrue man) vars
+    in
+    (* the current and next copies of bit i are the variables i and i+4 *)
+    let trel =
+      Array.init 4
+	(fun i -> Bdd.nxor (x (i+4)) (Bdd.xor (x i) (x ((i+1) mod 4))))
+    in
+    let rel = Array.fold_left Bdd.dand (Bdd.dtrue man) trel in
+    let supp = cube [0;1;2;3] in
+    let tsupp = [| Bdd.dtrue man; cube [0]; cube [1;3]; cube [2] |] in
+    let sets =
+      [ Bdd.xor (x 0) (x 2); Bdd.dand (x 1) (Bdd.dnot (x 3)); x 5 ]
+    in
+    let check () =
+      List.iter
+	(fun set ->
+	  let expected = Bdd.varmap (Bdd.existand supp set rel) in
+	  assert (Bdd.is_equal (Bdd.relprod_rename supp set rel) expected);
+	  let expected =
+	    let res = ref set in
+	    Array.iteri
+	      (fun i r -> res := Bdd.existand tsupp.(i) !res r)
+	      trel;
+	    Bdd.varmap !res
+	  in
+	  assert (Bdd.is_equal
+		    (Bdd.relprod_rename_vector tsupp trel set) expected))
+	sets
+    in
+    Man.set_varmap man (Array.init 8 (fun i -> if i<4 then i+4 else i-4));
+    check ();
+    Man.set_varmap man (Array.init 8 (fun i -> (i+4) mod 8 lxor 1));
+    check ();
+    begin try
+      ignore (Bdd.relprod_rename_vector [|supp|] trel (x 0));
+      assert false
+    with Invalid_argument _ -> ()
+    end
+  )
+
+(*  ********************************************************************** *)
+(** {2 Main} *)
+(*  ********************************************************************** *)
+
+let tests = [
+  ("failed_reordering", failed_reordering);
+  ("manager_lifetime", manager_lifetime);
+  ("timeout", timeout);
+  ("timeout_user", timeout_user);
+  ("compose_array", compose_array);
+  ("compose_sparse", compose_sparse);
+  ("chained_hashes", chained_hashes);
+  ("pending_derefs", pending_derefs);
+  ("nested_limits", nested_limits);
+  ("fused", fused);
+  ("batched", batched);
+  ("kernels", kernels);
+  ("expr", expr);
+  ("persistence", persistence);
+  ("guardleafs", guardleafs);
+  ("apply_array", apply_array);
+  ("image", image);
+  ("relprod_rename", relprod_rename);
+]
+
+let _ =
+  let names =
+    if Array.length Sys.argv > 1
+    then List.tl (Array.to_list Sys.argv)
+    else List.map fst tests
+  in
+  List.iter
+    (fun name ->
+      let test =
+	try List.assoc name tests
+	with Not_found -> eprintf "unknown test %s@." name; exit 2
+      in
+      test ();
+      printf "%s: ok@." name)
+    names
@@ -14,6 +14,7 @@ type common = Custom.common = {
 type ('a,'b) op1 = ('a,'b) Custom.op1 = {
   common1: common;
   closure1: 'a -> 'b;
+  batch1: bool;
 }
 
 type ('a,'b,'c) op2 = ('a,'b,'c) Custom.op2 = {
@@ -22,6 +23,7 @@ type ('a,'b,'c) op2 = ('a,'b,'c) Custom.op2 = {
   ospecial2: ('a Vdd.t -> 'b Vdd.t -> 'c Vdd.t option) option;
   commutative: bool;
   idempotent: bool;
+  batch2: bool;
 }
 
 type ('a,'b) test2 = ('a,'b) Custom.test2 = {
@@ -35,11 +37,13 @@ type ('a,'b,'c,'d) op3 = ('a,'b,'c,'d) Custom.op3 = {
   common3: common;
   closure3: 'a -> 'b -> 'c -> 'd;
   ospecial3: ('a Vdd.t -> 'b Vdd.t -> 'c Vdd.t -> 'd Vdd.t option) option;
+  batch3: bool;
 }
 type ('a,'b) opN = ('a,'b) Custom.opN = {
   commonN: common;
   arityNbdd : int;
   closureN: Bdd.vt array -> 'a Vdd.t array -> 'b Vdd.t option;
+  batchN: bool;
 }
 type ('a,'b) opG = ('a,'b) Custom.opG = {
   commonG: common;
@@ -92,6 +96,8 @@ let make_common ?memo arity =
   in
   { pid; arity; memo }
 
+let profile_common common = Custom.profile common.pid
+
 let clear_common common = Memo.clear common.memo
 let clear_op1 op = clear_common op.common1
 let clear_op2 op = clear_common op.common2
@@ -108,12 +114,13 @@ let clear_existandop1 op = clear_common op.commonexistandop1
 (** {3 Making operations} *)
 (*  ********************************************************************** *)
 
-let make_op1 ?memo op =
+let make_op1 ?memo ?(batch=false) op =
   let common = make_common 1 ?memo in
-  { common1 = common; closure1=op }
+  { common1 = common; closure1=op; batch1=batch }
 
 let make_op2
     ?memo
+    ?(batch=false)
     ?(commutative=false)
     ?(idempotent=false)
     ?special
@@ -126,6 +133,7 @@ let make_op2
     ospecial2=special;
     commutative=commutative;
     idempotent=idempotent;
+    batch2=batch;
   }
 let make_test2
     ?memo
@@ -146,6 +154,7 @@ let make_test2
   }
 let make_op3
     ?memo
+    ?(batch=false)
     ?special
     op
     =
@@ -154,10 +163,11 @@ let make_op3
     common3=common;
     closure3=op;
     ospecial3=special;
+    batch3=batch;
   }
-let make_opN ?memo arityB arityV op =
+let make_opN ?memo ?(batch=false) arityB arityV op =
   let common = make_common ?memo (arityB+arityV) in
-  { commonN=common; arityNbdd=arityB; closureN=op; }
+  { commonN=common; arityNbdd=arityB; closureN=op; batchN=batch; }
 let make_opG ?memo ?beforeRec ?ite arityB arityV op =
   let common = make_common ?memo (arityB+arityV) in
   {
@@ -199,20 +209,21 @@ let apply_existandop1 op ~supp = Custom._apply_existandop1 op supp
 (** {3 Map operations} *)
 (*  ********************************************************************** *)
 
-let map_op1 ?memo op d1 =
-  let op = make_op1 ?memo op in
+let map_op1 ?memo ?batch op d1 =
+  let op = make_op1 ?memo ?batch op in
   let res = apply_op1 op d1 in
   if memo=None then Memo.clear op.common1.memo;
   res
 
 let map_op2
     ?memo
+    ?batch
     ?commutative ?idempotent
     ?special
     op d1 d2
     =
   let op =
-    make_op2 ?memo
+    make_op2 ?memo ?batch
       ?commutative ?idempotent
       ?special op
   in
@@ -220,18 +231,18 @@ let map_op2
   if memo=None then Memo.clear op.common2.memo;
   res
 
-let map_op3 ?memo ?special op d1 d2 d3
+let map_op3 ?memo ?batch ?special op d1 d2 d3
     =
-  let op = make_op3 ?memo ?special op in
+  let op = make_op3 ?memo ?batch ?special op in
   let res = apply_op3 op d1 d2 d3 in
   if memo=None then Memo.clear op.common3.memo;
   res
 
-let map_opN ?memo op tbdd tvdd
+let map_opN ?memo ?batch op tbdd tvdd
     =
   let arityB = Array.length tbdd in
   let arityV = Array.length tvdd in
-  let op = make_opN ?memo arityB arityV op in
+  let op = make_opN ?memo ?batch arityB arityV op in
   let res = apply_opN op tbdd tvdd in
   if memo=None then Memo.clear op.commonN.memo;
   res
@@ -33,6 +33,10 @@ type common = Custom.common = {
 val newpid : unit -> Custom.pid
 val make_common : ?memo:Memo.t -> int -> common
 
+(** Profiling counters of the operations sharing the pid of [common],
+    see {!Custom.profile} and {!Man.set_profiling} *)
+val profile_common : common -> Custom.profile
+
 (*  ********************************************************************** *)
 (** {3 Unary operations} *)
 (*  ********************************************************************** *)
@@ -41,9 +45,17 @@ type ('a,'b) op1 = ('a,'b) Custom.op1 = private {
   common1: common;
   closure1: 'a -> 'b;
     (** Operation on leaves *)
+  batch1: bool;
+    (** Are leaves processed in batch ? *)
 }
-val make_op1 : ?memo:Memo.t -> ('a -> 'b) -> ('a, 'b) op1
-  (** Makes a binary operation, with the given memoization policy. *)
+val make_op1 : ?memo:Memo.t -> ?batch:bool -> ('a -> 'b) -> ('a, 'b) op1
+  (** Makes a binary operation, with the given memoization policy.
+
+      [batch] (default: [false]), when [true], makes {!apply_op1}
+      first collect all the leaves on which the operation is
+      needed, and then apply the operation to all of them within a
+      single call from C to OCaml, instead of one call per leaf.
+      This pays off on diagrams with many distinct leaves. *)
 val apply_op1 : ('a, 'b) op1 -> 'a Vdd.t -> 'b Vdd.t
 
 
@@ -97,15 +109,29 @@ type ('a,'b,'c) op2 = ('a,'b,'c) Custom.op2 = private {
     (** Is the operation commutative ? *)
   idempotent: bool;
     (** Is the operation idempotent ([op x x = x]) ? *)
+  batch2: bool;
+    (** Are pairs of leaves processed in batch ? *)
 }
 val make_op2 :
   ?memo:Memo.t ->
+  ?batch:bool ->
   ?commutative:bool ->
   ?idempotent:bool ->
   ?special:('a Vdd.t -> 'b Vdd.t -> 'c Vdd.t option) ->
   ('a -> 'b -> 'c) -> ('a, 'b, 'c) op2
   (** Makes a binary operation, with the given memoization policy.
 
+      [batch] (default: [false]), when [true], makes {!apply_op2}
+      proceed in two steps: it first collects all the distinct
+      pairs of leaves on which [op] is needed (and that are not
+      already in the memoization table), applies [op] to all of
+      them within a single call from C to OCaml, and then builds
+      the result. The [special] function, if any, is still called
+      once per pair of nodes. Dynamic reordering is disabled
+      during a batched application. The flag is ignored when the
+      operation is used as the combining operation of a
+      quantification.
+
       [commutative] (default: [false]), when [true], allows to
       optimize the cache usage (hence the speed) when the operation
       is commutative.
@@ -151,9 +177,12 @@ type ('a,'b,'c,'d) op3 = ('a,'b,'c,'d) Custom.op3 = private {
     (** Operation on leaves *)
   ospecial3: ('a Vdd.t -> 'b Vdd.t -> 'c Vdd.t -> 'd Vdd.t option) option;
     (** Special cases *)
+  batch3: bool;
+    (** Are triples of leaves processed in batch ? *)
 }
 val make_op3 :
   ?memo:Memo.t ->
+  ?batch:bool ->
   ?special:('a Vdd.t -> 'b Vdd.t -> 'c Vdd.t -> 'd Vdd.t option) ->
   ('a -> 'b -> 'c -> 'd) -> ('a, 'b, 'c, 'd) op3
 val apply_op3 :
@@ -186,12 +215,20 @@ type ('a,'b) opN = ('a,'b) Custom.opN = private {
   arityNbdd : int;
   closureN: Bdd.vt array -> 'a Vdd.t array -> 'b Vdd.t option;
     (** Operation on leaves *)
+  batchN: bool;
+    (** Are tuples processed in batch ? *)
 }
 val make_opN :
   ?memo:Memo.t ->
+  ?batch:bool ->
   int -> int ->
   (Bdd.vt array -> 'a Vdd.t array -> 'b Vdd.t option) ->
   ('a, 'b) opN
+  (** With [batch=true], the closure is applied within a single
+      call from C to OCaml to all the tuples reached at the same
+      stage of the recursion; tuples for which it returns [None]
+      are further decomposed, and their descendants are processed
+      in the next batch. *)
 val apply_opN : ('a, 'b) opN -> Bdd.vt array -> 'a Vdd.t array -> 'b Vdd.t
 
 (** N-ary general operation *)
@@ -381,20 +418,23 @@ val clear_existandop1	: ('a, 'b) existandop1	-> unit
     if [?memo=None], then a hash table is used, and cleared at the
     end. *)
 
-val map_op1 : ?memo:Memo.t -> ('a -> 'b) -> 'a Vdd.t -> 'b Vdd.t
+val map_op1 : ?memo:Memo.t -> ?batch:bool -> ('a -> 'b) -> 'a Vdd.t -> 'b Vdd.t
 val map_op2 :
   ?memo:Memo.t ->
+  ?batch:bool ->
   ?commutative:bool ->
   ?idempotent:bool ->
   ?special:('a Vdd.t -> 'b Vdd.t -> 'c Vdd.t option) ->
   ('a -> 'b -> 'c) -> 'a Vdd.t -> 'b Vdd.t -> 'c Vdd.t
 val map_op3 :
   ?memo:Memo.t ->
+  ?batch:bool ->
   ?special:('a Vdd.t -> 'b Vdd.t -> 'c Vdd.t -> 'd Vdd.t option) ->
   ('a -> 'b -> 'c -> 'd) ->
   'a Vdd.t -> 'b Vdd.t -> 'c Vdd.t -> 'd Vdd.t
 val map_opN :
   ?memo:Memo.t ->
+  ?batch:bool ->
   (Bdd.vt array -> 'a Vdd.t array -> 'b Vdd.t option) ->
   Bdd.vt array -> 'a Vdd.t array -> 'b Vdd.t
 val map_test2 :